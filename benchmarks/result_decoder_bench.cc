@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+
+#include <cpqd/asr-client/recognition_result.h>
+
+#include "json11.hpp"
+
+#include "src/asr_result_decoder.h"
+
+// Decode time and heap allocations per RECOGNITION_RESULT body, comparing the
+// single pass decoder against the former json11 document walk.
+//
+// Usage: result_decoder_bench [iterations] [alternatives] [words]
+
+static std::atomic<unsigned long> allocations{0};
+
+void* operator new(std::size_t size) {
+  ++allocations;
+  void* p = std::malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// The json11 based decoding used before ASRResultDecoder, kept as baseline
+RecognitionResult json11Decode(const std::string& body) {
+  std::string err;
+  json11::Json json = json11::Json::parse(body, err);
+
+  RecognitionResult res(json["result_status"].string_value());
+  for (auto &k : json["alternatives"].array_items()) {
+    RecognitionResult::Alternative alt;
+
+    int score = k["score"].int_value();
+    alt.confidence(score).text(k["text"].string_value());
+    for (auto &interp : k["interpretations"].array_items()) {
+      alt.addInterpretation(interp.string_value());
+    }
+    for (auto &word : k["words"].array_items()) {
+      alt.addWord(word["text"].string_value(),
+                  word["score"].int_value(),
+                  word["start_time"].number_value(),
+                  word["end_time"].number_value());
+    }
+    res.addAlternatives(alt);
+    auto as = json["age_scores"];
+    if (as.is_object() && !as.object_items().empty()) {
+      std::string age = std::to_string(as["age"].number_value());
+      res.getClassifiers().setAge(age);
+    }
+  }
+  if (json["start_time"].is_number())
+    res.setStartTime(json["start_time"].number_value());
+  if (json["end_time"].is_number())
+    res.setEndTime(json["end_time"].number_value());
+  return res;
+}
+
+std::string makeBody(int alternatives, int words) {
+  std::stringstream ss;
+  ss << "{\"alternatives\": [";
+  for (int a = 0; a < alternatives; ++a) {
+    if (a) ss << ", ";
+    ss << "{\"text\": \"";
+    for (int w = 0; w < words; ++w) ss << (w ? " " : "") << "palavra" << w;
+    ss << "\", \"score\": " << 90 - a << ", \"interpretations\": [\"interp"
+       << a << "\"], \"words\": [";
+    for (int w = 0; w < words; ++w) {
+      if (w) ss << ", ";
+      ss << "{\"text\": \"palavra" << w << "\", \"score\": 91, "
+         << "\"start_time\": " << w * 0.25 << ", \"end_time\": "
+         << w * 0.25 + 0.2 << "}";
+    }
+    ss << "]}";
+  }
+  ss << "], \"age_scores\": {\"age\": 30}, \"segment_index\": 0, "
+     << "\"last_segment\": true, \"final_result\": true, "
+     << "\"start_time\": 0.1, \"end_time\": 9.5, "
+     << "\"result_status\": \"RECOGNIZED\"}";
+  return ss.str();
+}
+
+template <typename F>
+void run(const std::string& name, int iterations, F decode) {
+  unsigned long before = allocations;
+  auto start = std::chrono::steady_clock::now();
+  size_t sink = 0;
+  for (int i = 0; i < iterations; ++i) {
+    RecognitionResult res = decode();
+    sink += res.getAlternatives().size();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+  unsigned long allocs = allocations - before;
+
+  std::cout << name << ": "
+            << elapsed.count() / iterations << " ns/result, "
+            << static_cast<double>(allocs) / iterations << " allocs/result"
+            << " (" << sink << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+  int alternatives = argc > 2 ? std::atoi(argv[2]) : 10;
+  int words = argc > 3 ? std::atoi(argv[3]) : 12;
+
+  std::string body = makeBody(alternatives, words);
+  std::cout << "body: " << body.size() << " bytes, " << alternatives
+            << " alternatives, " << words << " words each" << std::endl;
+
+  run("json11 DOM       ", iterations,
+      [&body]() { return json11Decode(body); });
+
+  ASRResultDecoder decoder;
+  run("single pass      ", iterations, [&body, &decoder]() {
+    ASRResultDecoder::Routing routing;
+    RecognitionResult res;
+    decoder.decode(body, routing, res);
+    return res;
+  });
+
+  ASRResultDecoder::Options options;
+  options.words = false;
+  ASRResultDecoder no_words(options);
+  run("single pass/words", iterations, [&body, &no_words]() {
+    ASRResultDecoder::Routing routing;
+    RecognitionResult res;
+    no_words.decode(body, routing, res);
+    return res;
+  });
+
+  return 0;
+}
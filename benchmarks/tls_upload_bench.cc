@@ -0,0 +1,265 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Client CPU spent uploading audio over TLS, per stream, for three paths:
+//
+//   asio engine  what the recognizer does: OpenSSL writes records to a
+//                memory BIO pair copied to the socket, and the frame header
+//                and its payload are written, and flushed, separately
+//   socket BIO   one record per frame, OpenSSL writes to the socket
+//   kTLS         socket BIO with SSL_OP_ENABLE_KTLS, records are encrypted
+//                by the kernel when OpenSSL and the kernel support it
+//
+// A stream is 8 kHz 16 bit audio, 16000 bytes per second, sent in frames of
+// the given duration. The cost is the client thread CPU time per second of
+// audio; the server runs on another thread and is not accounted.
+//
+// Usage: tls_upload_bench cert.pem key.pem [audio seconds] [frame ms]
+
+namespace {
+
+const size_t kBytesPerSecond = 16000;
+// websocket client frame header with a 16 bit length and the mask key
+const size_t kFrameHeader = 8;
+
+double threadCpuSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+bool sendAll(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t n = send(fd, data, size, 0);
+    if (n <= 0) return false;
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+// Loopback TCP connection, the server side reads and discards until EOF
+class Connection {
+ public:
+  explicit Connection(SSL_CTX* server_ctx) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    bind(listener, reinterpret_cast<sockaddr*>(&addr), len);
+    listen(listener, 1);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len);
+
+    server_ = std::thread([listener, server_ctx]() {
+      int fd = accept(listener, nullptr, nullptr);
+      close(listener);
+      SSL* ssl = SSL_new(server_ctx);
+      SSL_set_fd(ssl, fd);
+      if (SSL_accept(ssl) == 1) {
+        std::vector<char> buf(64 * 1024);
+        while (SSL_read(ssl, buf.data(), buf.size()) > 0) {
+        }
+      }
+      SSL_free(ssl);
+      close(fd);
+    });
+
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    connect(fd_, reinterpret_cast<sockaddr*>(&addr), len);
+  }
+
+  ~Connection() {
+    shutdown(fd_, SHUT_WR);
+    server_.join();
+    close(fd_);
+  }
+
+  int fd() const { return fd_; }
+
+ private:
+  int fd_;
+  std::thread server_;
+};
+
+// Copy the records OpenSSL left in the memory BIO to the socket
+bool flush(BIO* ext, int fd) {
+  char buf[17 * 1024];
+  int n;
+  while ((n = BIO_read(ext, buf, sizeof(buf))) > 0) {
+    if (!sendAll(fd, buf, n)) return false;
+  }
+  return true;
+}
+
+// Feed socket input to the memory BIO, as the asio engine does
+bool fill(BIO* ext, int fd) {
+  char buf[17 * 1024];
+  ssize_t n = recv(fd, buf, sizeof(buf), 0);
+  return n > 0 && BIO_write(ext, buf, n) == n;
+}
+
+double asioEngine(SSL_CTX* client_ctx, SSL_CTX* server_ctx, size_t frames,
+                  size_t frame_size) {
+  Connection conn(server_ctx);
+  SSL* ssl = SSL_new(client_ctx);
+  BIO* int_bio;
+  BIO* ext_bio;
+  BIO_new_bio_pair(&int_bio, 0, &ext_bio, 0);
+  SSL_set_bio(ssl, int_bio, int_bio);
+  SSL_set_connect_state(ssl);
+
+  int ret;
+  while ((ret = SSL_do_handshake(ssl)) != 1) {
+    if (!flush(ext_bio, conn.fd())) return -1;
+    if (SSL_get_error(ssl, ret) != SSL_ERROR_WANT_READ ||
+        !fill(ext_bio, conn.fd()))
+      return -1;
+  }
+  if (!flush(ext_bio, conn.fd())) return -1;
+
+  std::vector<char> header(kFrameHeader, 'h');
+  std::vector<char> payload(frame_size, 'a');
+  double start = threadCpuSeconds();
+  for (size_t i = 0; i < frames; ++i) {
+    SSL_write(ssl, header.data(), header.size());
+    flush(ext_bio, conn.fd());
+    SSL_write(ssl, payload.data(), payload.size());
+    flush(ext_bio, conn.fd());
+  }
+  double cpu = threadCpuSeconds() - start;
+
+  SSL_free(ssl);
+  BIO_free(ext_bio);
+  return cpu;
+}
+
+double socketBio(SSL_CTX* client_ctx, SSL_CTX* server_ctx, size_t frames,
+                 size_t frame_size, bool ktls, bool& ktls_active) {
+  Connection conn(server_ctx);
+  SSL* ssl = SSL_new(client_ctx);
+#ifdef SSL_OP_ENABLE_KTLS
+  if (ktls) SSL_set_options(ssl, SSL_OP_ENABLE_KTLS);
+#endif
+  SSL_set_fd(ssl, conn.fd());
+  if (SSL_connect(ssl) != 1) return -1;
+
+  ktls_active = false;
+#ifdef SSL_OP_ENABLE_KTLS
+  ktls_active = ktls && BIO_get_ktls_send(SSL_get_wbio(ssl));
+#endif
+  (void)ktls;
+
+  std::vector<char> frame(kFrameHeader + frame_size, 'a');
+  double start = threadCpuSeconds();
+  for (size_t i = 0; i < frames; ++i) {
+    SSL_write(ssl, frame.data(), frame.size());
+  }
+  double cpu = threadCpuSeconds() - start;
+
+  SSL_free(ssl);
+  return cpu;
+}
+
+void report(const std::string& name, double cpu, double audio_seconds) {
+  if (cpu < 0) {
+    std::cout << name << ": failed" << std::endl;
+    return;
+  }
+  double us_per_second = cpu * 1e6 / audio_seconds;
+  std::cout << name << ": " << us_per_second
+            << " us CPU per stream second, "
+            << static_cast<long>(1e6 / us_per_second) << " streams per core"
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0]
+              << " cert.pem key.pem [audio seconds] [frame ms]" << std::endl;
+    return 1;
+  }
+  double audio_seconds = argc > 3 ? std::atof(argv[3]) : 600;
+  unsigned int frame_ms = argc > 4 ? std::atoi(argv[4]) : 20;
+
+  size_t frame_size = kBytesPerSecond * frame_ms / 1000;
+  size_t frames = static_cast<size_t>(audio_seconds * 1000 / frame_ms);
+
+  SSL_library_init();
+  SSL_load_error_strings();
+
+  SSL_CTX* server_ctx = SSL_CTX_new(SSLv23_server_method());
+  if (!SSL_CTX_use_certificate_file(server_ctx, argv[1], SSL_FILETYPE_PEM) ||
+      !SSL_CTX_use_PrivateKey_file(server_ctx, argv[2], SSL_FILETYPE_PEM)) {
+    ERR_print_errors_fp(stderr);
+    return 1;
+  }
+  SSL_CTX* client_ctx = SSL_CTX_new(SSLv23_client_method());
+  // AES-GCM, the ciphers the kernel can offload
+  SSL_CTX_set_cipher_list(client_ctx, "AESGCM");
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+  SSL_CTX_set_ciphersuites(client_ctx, "TLS_AES_128_GCM_SHA256");
+#endif
+
+  std::cout << frames << " frames of " << frame_size << " bytes, "
+            << audio_seconds << " s of audio" << std::endl;
+
+  report("asio engine", asioEngine(client_ctx, server_ctx, frames, frame_size),
+         audio_seconds);
+
+  bool ktls_active;
+  report("socket BIO ", socketBio(client_ctx, server_ctx, frames, frame_size,
+                                  false, ktls_active),
+         audio_seconds);
+
+#ifdef SSL_OP_ENABLE_KTLS
+  double cpu = socketBio(client_ctx, server_ctx, frames, frame_size, true,
+                         ktls_active);
+  if (ktls_active)
+    report("kTLS       ", cpu, audio_seconds);
+  else
+    report("kTLS unavailable, user space fallback", cpu, audio_seconds);
+#else
+  std::cout << "kTLS: not supported by this OpenSSL" << std::endl;
+#endif
+
+  SSL_CTX_free(client_ctx);
+  SSL_CTX_free(server_ctx);
+  return 0;
+}
@@ -93,13 +93,13 @@ int main(int argc, char* argv[]) {
     }
 
     int i = 0;
-    for (RecognitionResult::Alternative& alt : res.getAlternatives()) {
+    for (const RecognitionResult::Alternative& alt : res.getAlternatives()) {
       std::cout << "Res [" << j
                 << "] Alt [" << ++i
                 << "] (score = " << alt.getConfidence()
                 << "): " << alt.getText() << std::endl;
       int j = 0;
-      for (Interpretation& interpretation : alt.getInterpretations()) {
+      for (const Interpretation& interpretation : alt.getInterpretations()) {
         std::cout << "\t Interpretacao [" << ++j
                   << "]: " << interpretation.text_ << std::endl;
       }
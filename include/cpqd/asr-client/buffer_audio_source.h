@@ -19,6 +19,7 @@
 
 #include <cpqd/asr-client/audio_source.h>
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 
@@ -33,10 +34,31 @@ class BufferAudioSource : public AudioSource {
 
   int read(std::vector<char>& buffer);
 
+  /// Write audio to the buffer, without waiting
+  /**
+   * @return false if the source is finished or the audio did not fit in the
+   *   buffer. Audio that did not fit is dropped.
+   */
   bool write(std::vector<char>& buffer);
   
   bool write(char* buffer, size_t size);
 
+  /// Write audio to the buffer, waiting for the recognizer to read it
+  /**
+   * The recognizer stops reading the buffer while the connection to the
+   * server is congested, so waiting here propagates that back pressure to
+   * the audio producer instead of dropping audio.
+   *
+   * @param [in] timeout Maximum time to wait for room in the buffer.
+   * @return false if the source is finished or the timeout expired before
+   *   all the audio was written.
+   */
+  bool write(const char* buffer, size_t size,
+             std::chrono::milliseconds timeout);
+
+  /// Bytes that can be written without dropping audio
+  size_t writeAvailable();
+
   void close();
 
   void finish();
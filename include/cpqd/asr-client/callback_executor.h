@@ -0,0 +1,51 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef INCLUDE_CPQD_ASR_CLIENT_CALLBACK_EXECUTOR_H_
+#define INCLUDE_CPQD_ASR_CLIENT_CALLBACK_EXECUTOR_H_
+
+#include <functional>
+#include <memory>
+
+/// Runs the RecognitionListener callbacks of a SpeechRecognizer
+/**
+ * By default listeners are called inline on the WebSocket I/O thread. A
+ * different executor keeps slow listeners from stalling the connection.
+ *
+ * Applications may implement this interface on top of their own thread pool.
+ * Tasks may run on any thread and in any order; the recognizer serializes
+ * its own callbacks, so listeners of one recognizer are never called
+ * concurrently and always observe events in the order they were received.
+ */
+class CallbackExecutor {
+ public:
+  virtual ~CallbackExecutor() = default;
+
+  /// Run a task, now or later. Tasks must not be discarded.
+  virtual void execute(std::function<void()> task) = 0;
+
+  /// Executor that runs every task on the calling thread
+  static std::shared_ptr<CallbackExecutor> inlineExecutor();
+
+  /// Executor backed by one dedicated thread
+  /**
+   * The executor may be shared by several recognizers. Its thread is joined
+   * when the last reference to it is released.
+   */
+  static std::shared_ptr<CallbackExecutor> dedicatedThread();
+};
+
+#endif  // INCLUDE_CPQD_ASR_CLIENT_CALLBACK_EXECUTOR_H_
@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef INCLUDE_CPQD_ASR_CLIENT_COMPLETION_QUEUE_H_
+#define INCLUDE_CPQD_ASR_CLIENT_COMPLETION_QUEUE_H_
+
+#include <cpqd/asr-client/recognition_result.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+/// Completion events of many recognizers, consumed by a single thread
+/**
+ * Recognizers attached with SpeechRecognizer::Builder::completionQueue()
+ * post one event per recognition when it finishes, successfully or not. A
+ * thread can then serve any number of recognizers with waitAny() or poll()
+ * instead of blocking on each waitRecognitionResult().
+ *
+ * The results of a recognition are delivered in its event only, they are not
+ * available to waitRecognitionResult() or nextResult() afterwards.
+ */
+class CompletionQueue {
+ public:
+  struct Event {
+    /// Identifier given when the recognizer was attached
+    uint64_t id_ = 0;
+
+    /// Final results of the recognition
+    std::vector<RecognitionResult> results_;
+
+    /// Set if the recognition failed
+    std::exception_ptr error_ = nullptr;
+
+    bool ok() const { return !error_; }
+
+    /// Throw the recognition error, if any
+    void rethrow() const {
+      if (error_) std::rethrow_exception(error_);
+    }
+  };
+
+  CompletionQueue() = default;
+
+  CompletionQueue(const CompletionQueue&) = delete;
+  CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+  /// Wait for the next event
+  /**
+   * @return false on timeout or after shutdown() once the queue is empty.
+   */
+  bool waitAny(Event& event, std::chrono::milliseconds timeout);
+
+  /// Take the next event without waiting
+  /**
+   * @return false if no event is available.
+   */
+  bool poll(Event& event);
+
+  /// Post an event, called by the recognizers
+  void post(Event event);
+
+  /// Wake up all waiters, waitAny() no longer blocks
+  void shutdown();
+
+  /// Number of events waiting to be consumed
+  size_t size();
+
+ private:
+  std::mutex lock_;
+  std::condition_variable cv_;
+  std::deque<Event> events_;
+  bool shutdown_ = false;
+};
+
+#endif  // INCLUDE_CPQD_ASR_CLIENT_COMPLETION_QUEUE_H_
@@ -0,0 +1,327 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#ifndef INCLUDE_CPQD_ASR_CLIENT_ENDPOINT_GROUP_H_
+#define INCLUDE_CPQD_ASR_CLIENT_ENDPOINT_GROUP_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+/// How an EndpointGroup picks the server of a new connection
+enum class EndpointPolicy {
+  /// Each server in turn
+  ROUND_ROBIN,
+
+  /// The server with the fewest connections open by the group users
+  LEAST_OUTSTANDING,
+
+  /// Random, weighted by the inverse of the average connection setup time
+  LATENCY_WEIGHTED,
+
+  /// The same server for the same Channel-Identifier, by rendezvous hashing
+  CHANNEL_AFFINITY,
+};
+
+/// Class of a recognition waiting for admission, strictly ordered
+enum class RecognitionPriority {
+  /// Live calls, a person waits for the result
+  LIVE,
+
+  NORMAL,
+
+  /// Background transcription, only takes slots nobody else waits for
+  BATCH,
+};
+
+/// A set of equivalent ASR servers shared by many recognizers
+/**
+ * Recognizers attached with SpeechRecognizer::Builder::endpoints() ask the
+ * group for a server every time they connect, instead of using serverUrl().
+ *
+ * Every server has a circuit breaker. After a number of consecutive
+ * failures (refused connections, connections lost or setups slower than a
+ * limit) the server is left out for a while. Then a single connection is
+ * allowed through as a probe: the server is back if it succeeds, out again
+ * otherwise. When every server is out the one due first is tried anyway.
+ */
+class EndpointGroup {
+ public:
+  struct Options {
+    EndpointPolicy policy_ = EndpointPolicy::ROUND_ROBIN;
+
+    /// Consecutive failures that take a server out
+    unsigned int failure_threshold_ = 3;
+
+    /// Time a server stays out before a probe
+    std::chrono::milliseconds open_time_{10000};
+
+    /// Connection setups slower than this count as failures, 0 disables
+    std::chrono::milliseconds slow_setup_{0};
+
+    /// Weight of the last setup time in its moving average
+    double setup_time_weight_ = 0.2;
+
+    /// Percentile of the result latency after which a recognition is sent
+    /// to a second server too, 0 disables hedging
+    /**
+     * The latency is the time from the end of the audio to the last final
+     * result, as seen by the recognizers of the group.
+     */
+    double hedge_percentile_ = 0;
+
+    /// Most recognitions hedged, as a fraction of those that could be
+    double hedge_budget_ = 0.05;
+
+    /// Initial limit of recognitions in flight per server, 0 disables the
+    /// admission control
+    /**
+     * The limit adapts to the server (AIMD): it grows by one every limit
+     * recognitions whose result latency stays within the tolerance and is
+     * cut by the backoff ratio when a recognition fails, times out or its
+     * latency goes beyond the tolerance. A connection setup beyond the
+     * tolerance of the usual setup time, or beyond the slow setup time,
+     * cuts it as well.
+     */
+    unsigned int concurrency_limit_ = 0;
+    unsigned int min_concurrency_ = 1;
+    unsigned int max_concurrency_ = 1000;
+
+    /// Latencies and setup times above this multiple of the usual ones are
+    /// overload
+    double latency_tolerance_ = 2.0;
+
+    /// Factor the limit is multiplied by on overload
+    double backoff_ratio_ = 0.9;
+
+    /// Time a recognition waits for a slot before it is rejected
+    std::chrono::milliseconds admission_wait_{0};
+
+    /// Share of the slots of each tenant within a priority class
+    /**
+     * Waiting recognitions of the same class get slots by weighted fair
+     * queuing over their tenants, a tenant not listed weighs 1.
+     */
+    std::map<std::string, double> tenant_weights_;
+  };
+
+  /// A recognition asking for a slot
+  struct Admission {
+    RecognitionPriority priority_ = RecognitionPriority::NORMAL;
+
+    /// Fair queuing key, RecognitionConfig::accountTag() by default
+    std::string tenant_;
+
+    /// Wait for a slot, up to the admission wait of the options
+    bool wait_ = true;
+  };
+
+  /// State of a server
+  struct Stats {
+    std::string url_;
+
+    /// Connections currently open to the server
+    unsigned int outstanding_ = 0;
+
+    /// Moving average of the connection setup time
+    std::chrono::microseconds setup_time_{0};
+
+    /// Consecutive failures
+    unsigned int failures_ = 0;
+
+    /// False while the circuit breaker keeps the server out
+    bool available_ = true;
+
+    /// Times the server was taken out
+    uint64_t ejections_ = 0;
+
+    /// Connections handed to the server
+    uint64_t selections_ = 0;
+
+    /// Recognitions admitted and not completed yet
+    unsigned int in_flight_ = 0;
+
+    /// Current limit of recognitions in flight, 0 without admission control
+    unsigned int concurrency_limit_ = 0;
+
+    /// Recognitions rejected because the server was at its limit
+    uint64_t rejections_ = 0;
+
+    /// Recognitions waiting for a slot
+    size_t queued_ = 0;
+  };
+
+  /// No server to avoid
+  static const size_t kNoEndpoint = static_cast<size_t>(-1);
+
+  /// Latencies seen before recognitions are hedged
+  static const size_t kMinLatencySamples = 20;
+
+  /// Latencies the percentile is taken from, the most recent ones
+  static const size_t kLatencySamples = 200;
+
+  /**
+   * @param [in] urls Server URLs, ws:// or wss://.
+   * @throws std::invalid_argument if the list is empty or a URL is invalid.
+   */
+  explicit EndpointGroup(const std::vector<std::string>& urls);
+  EndpointGroup(const std::vector<std::string>& urls, const Options& options);
+
+  EndpointGroup(const EndpointGroup&) = delete;
+  EndpointGroup& operator=(const EndpointGroup&) = delete;
+
+  /// Pick the server of a new connection
+  /**
+   * The connection must be returned with release().
+   *
+   * @param [in] channel Channel-Identifier of the recognizer, used by the
+   *   CHANNEL_AFFINITY policy.
+   * @param [in] avoid A server not to pick unless it is the only one left,
+   *   the one of the recognition being hedged.
+   * @return The index of the server.
+   */
+  size_t acquire(const std::string& channel = std::string(),
+                 size_t avoid = kNoEndpoint);
+
+  /// The connection to the server was closed
+  void release(size_t endpoint);
+
+  /// A connection to the server was set up in the given time
+  void succeeded(size_t endpoint, std::chrono::microseconds setup_time);
+
+  /// A connection to the server failed or was lost
+  void failed(size_t endpoint);
+
+  /// Take a slot for a recognition on the server
+  /**
+   * Waits up to the admission wait of the options when the server is at
+   * its limit. Freed slots go to the waiting recognitions of the highest
+   * priority class first, and within a class to the tenant with the
+   * earliest weighted fair queuing finish tag. Always true without
+   * admission control.
+   *
+   * @return false if no slot was free, the recognition must not start.
+   */
+  bool admit(size_t endpoint);
+  bool admit(size_t endpoint, const Admission& admission);
+
+  /// A recognition admitted on the server ended
+  /**
+   * @param [in] latency Time from the end of the audio to the last final
+   *   result, zero if there was no result.
+   * @param [in] overload Whether the recognition failed or timed out.
+   */
+  void complete(size_t endpoint, std::chrono::microseconds latency,
+                bool overload);
+
+  /// The audio of a recognition has ended, when should it be hedged
+  /**
+   * @param [out] delay Time to wait for the last final result.
+   * @return false if hedging is disabled or too few latencies were seen.
+   */
+  bool hedgeDelay(std::chrono::milliseconds& delay);
+
+  /// Take a hedge from the budget
+  /**
+   * @return false if the budget is spent, the recognition is not hedged.
+   */
+  bool takeHedge();
+
+  /// Time from the end of the audio to the last final result
+  void recordLatency(std::chrono::microseconds latency);
+
+  const std::string& url(size_t endpoint) const;
+
+  size_t size() const { return endpoints_.size(); }
+
+  std::vector<Stats> stats();
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  static const size_t kPriorities = 3;
+
+  struct Waiter {
+    size_t priority;
+    double finish;
+    uint64_t seq;
+    bool granted;
+  };
+
+  // Fair queuing state of a priority class: the finish tag of the last
+  // recognition admitted and the last finish tag of every waiting tenant
+  struct FairQueue {
+    double virtual_time = 0;
+    std::map<std::string, double> finish;
+  };
+
+  struct Endpoint {
+    std::string url;
+    uint64_t key = 0;
+    unsigned int outstanding = 0;
+    double setup_us = 0;
+    bool measured = false;
+    unsigned int failures = 0;
+    bool open = false;
+    bool probing = false;
+    Clock::time_point retry_at;
+    uint64_t ejections = 0;
+    uint64_t selections = 0;
+    unsigned int in_flight = 0;
+    double limit = 0;
+    // usual result latency, a slow moving average
+    double latency_us = 0;
+    uint64_t rejections = 0;
+    std::list<Waiter*> waiters;
+    FairQueue classes[kPriorities];
+  };
+
+  bool selectable(const Endpoint& endpoint, Clock::time_point now) const;
+  size_t pick(const std::vector<size_t>& candidates,
+              const std::string& channel);
+  void failure(Endpoint& endpoint, Clock::time_point now);
+  void decrease(Endpoint& endpoint);
+  bool hasSlot(const Endpoint& endpoint) const;
+  // Grant free slots to the best waiters
+  void dispatch(Endpoint& endpoint);
+  // A waiter of the class was granted or gave up
+  void left(Endpoint& endpoint, size_t priority);
+
+  Options options_;
+  std::vector<Endpoint> endpoints_;
+
+  std::mutex lock_;
+  std::condition_variable admission_cv_;
+  uint64_t admission_seq_ = 0;
+  size_t next_ = 0;
+  std::minstd_rand random_;
+
+  // result latencies in microseconds, a ring of the last kLatencySamples
+  std::vector<int64_t> latencies_;
+  size_t next_latency_ = 0;
+  uint64_t hedge_eligible_ = 0;
+  uint64_t hedges_ = 0;
+};
+
+#endif  // INCLUDE_CPQD_ASR_CLIENT_ENDPOINT_GROUP_H_
@@ -20,6 +20,8 @@
 #include <memory>
 #include <string>
 
+class ASRMessageRequest;
+
 class LanguageModelList {
  public:
   class Builder;
@@ -41,15 +43,21 @@ class LanguageModelList {
  public:
   LanguageModelList() = delete;
 
-  std::string getUri();
+  const std::string& getUri() const;
 
-  std::string getGrammarBody();
+  const std::string& getGrammarBody() const;
 
  private:
   explicit LanguageModelList(const Properties& properties)
       : properties_(properties) {}
 
   Properties properties_;
+
+  // START_RECOGNITION message of this model, framed on first use and shared
+  // by every recognition using the same instance
+  mutable std::shared_ptr<const std::string> start_message_;
+
+  friend class ASRMessageRequest;
 };
 
 class LanguageModelList::Builder {
@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#ifndef INCLUDE_CPQD_ASR_CLIENT_LANGUAGE_MODEL_REGISTRY_H_
+#define INCLUDE_CPQD_ASR_CLIENT_LANGUAGE_MODEL_REGISTRY_H_
+
+#include <cpqd/asr-client/language_model_list.h>
+
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/// Named language models loaded once and shared by every recognizer
+/**
+ * Models are immutable once loaded, the same instance is handed to every
+ * recognition using it, which also shares its START_RECOGNITION message:
+ *
+ *     LanguageModelRegistry& registry = LanguageModelRegistry::global();
+ *     registry.addGrammarFile("menu", "menu.gram");
+ *     ...
+ *     recognizer->recognize(audio, registry.get("menu"));
+ *
+ * Grammar files are reloaded when their modification time changes. The file
+ * is checked at most once per reload check interval, on get(), and read
+ * without holding the registry lock; recognitions running keep the model
+ * they started with.
+ */
+class LanguageModelRegistry {
+ public:
+  LanguageModelRegistry() = default;
+
+  LanguageModelRegistry(const LanguageModelRegistry&) = delete;
+  LanguageModelRegistry& operator=(const LanguageModelRegistry&) = delete;
+
+  /// Registry shared by the whole process
+  static LanguageModelRegistry& global();
+
+  /// Register a model by its URI, replacing any model with the same name
+  void addFromURI(const std::string& name, const std::string& uri);
+
+  /// Register an inline grammar, replacing any model with the same name
+  void addInlineGrammar(const std::string& name, const std::string& body);
+
+  /// Register a grammar read from a file, replacing any model with the name
+  /**
+   * @throws RecognitionException if the file can't be read.
+   */
+  void addGrammarFile(const std::string& name, const std::string& path);
+
+  /// Get a model, reloading its grammar file if it was modified
+  /**
+   * If a modified file can't be read the previous version is kept.
+   *
+   * @throws RecognitionException if no model has this name.
+   */
+  std::shared_ptr<const LanguageModelList> get(const std::string& name);
+
+  /// Unregister a model, recognitions using it are not affected
+  void remove(const std::string& name);
+
+  /// How often grammar files are checked for modifications
+  void setReloadCheckInterval(std::chrono::milliseconds interval);
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Entry {
+    std::shared_ptr<const LanguageModelList> lm_;
+
+    // grammar file, empty for models registered otherwise
+    std::string path_;
+    std::time_t mtime_ = 0;
+    Clock::time_point checked_;
+  };
+
+  std::mutex lock_;
+  std::map<std::string, Entry> models_;
+  std::chrono::milliseconds reload_check_interval_{1000};
+};
+
+#endif  // INCLUDE_CPQD_ASR_CLIENT_LANGUAGE_MODEL_REGISTRY_H_
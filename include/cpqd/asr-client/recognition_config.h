@@ -18,6 +18,7 @@
 #define INCLUDE_CPQD_ASR_CLIENT_RECOGNITION_CONFIG_H_
 
 #include <memory>
+#include <string>
 
 constexpr const char* CONFIDENCE_THRESHOLD = "CONFIDENCE_THRESHOLD";
 constexpr const char* MAX_SENTENCES = "MAX_SENTENCES";
@@ -111,28 +112,28 @@ class RecognitionConfig {
 
   void getConfigFromEvironment(bool replace_empty = false);
 
-  unsigned int confidenceThreshold();
-  unsigned int maxSentences();
-  unsigned int noInputTimeoutMilliseconds();
-  unsigned int recognitionTimeoutSeconds();
-  bool noInputTimeoutEnabled();
-  bool recognitionTimeoutEnabled();
-  bool inferAgeEnabled();
-  bool inferEmotionEnabled();
-  bool inferGenderEnabled();
-  unsigned int headMarginMilliseconds();
-  unsigned int tailMarginMilliseconds();
-  unsigned int waitEndMilliseconds();
-  bool continuousMode();
-  unsigned int maxSegmentDuration();
-  bool startInputTimers();
-  unsigned int endpointerAutoLevelLen();
-  unsigned int endpointerLevelMode();
-  unsigned int endpointerLevelThreshold();
-  bool verifyBufferUtterance();
-  std::string accountTag();
-  std::string channelIdentifier();
-  std::string mediaType();
+  unsigned int confidenceThreshold() const;
+  unsigned int maxSentences() const;
+  unsigned int noInputTimeoutMilliseconds() const;
+  unsigned int recognitionTimeoutSeconds() const;
+  bool noInputTimeoutEnabled() const;
+  bool recognitionTimeoutEnabled() const;
+  bool inferAgeEnabled() const;
+  bool inferEmotionEnabled() const;
+  bool inferGenderEnabled() const;
+  unsigned int headMarginMilliseconds() const;
+  unsigned int tailMarginMilliseconds() const;
+  unsigned int waitEndMilliseconds() const;
+  bool continuousMode() const;
+  unsigned int maxSegmentDuration() const;
+  bool startInputTimers() const;
+  unsigned int endpointerAutoLevelLen() const;
+  unsigned int endpointerLevelMode() const;
+  unsigned int endpointerLevelThreshold() const;
+  bool verifyBufferUtterance() const;
+  std::string accountTag() const;
+  std::string channelIdentifier() const;
+  std::string mediaType() const;
 
  private:
   explicit RecognitionConfig(const Properties& properties)
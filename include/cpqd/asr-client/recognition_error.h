@@ -32,6 +32,10 @@ class RecognitionError {
 
     // Another recognition is currently running
     ACTIVE_RECOGNITION,
+
+    // The server already runs as many recognitions as the client admits,
+    // see EndpointGroup::Options::concurrency_limit_
+    OVERLOADED,
   };
 
   RecognitionError(Code code, std::string message = std::string());
@@ -34,9 +34,27 @@ class RecognitionListener {
 
   virtual void onSpeechStop(int time) = 0;
 
-  virtual void onPartialRecognition(PartialRecognition &partial) = 0;
-
-  virtual void onRecognitionResult(RecognitionResult &result) = 0;
+  /// Called on every partial result
+  /**
+   * The same object is passed to all listeners, copy what must outlive the
+   * call.
+   */
+  virtual void onPartialRecognition(const PartialRecognition &partial) = 0;
+
+  /// Called on every final result
+  /**
+   * The same object is passed to all listeners, copy what must outlive the
+   * call.
+   */
+  virtual void onRecognitionResult(const RecognitionResult &result) = 0;
+
+  /// Called for partial and final results when raw results are enabled
+  /**
+   * With SpeechRecognizer::Builder::rawResults(true) the result bodies are
+   * not decoded: this method is called instead of onPartialRecognition and
+   * onRecognitionResult.
+   */
+  virtual void onRawRecognitionResult(const RawRecognitionResult &) {}
 
   virtual void onError(RecognitionError& error) = 0;
 };
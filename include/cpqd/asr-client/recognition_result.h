@@ -17,9 +17,12 @@
 #ifndef INCLUDE_CPQD_ASR_CLIENT_RECOGNITION_RESULT_H_
 #define INCLUDE_CPQD_ASR_CLIENT_RECOGNITION_RESULT_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
+class ASRResultDecoder;
+
 class RecognitionResult {
  public:
   enum Code {
@@ -39,15 +42,15 @@ class RecognitionResult {
 
   class Classifier {
    public:
-    std::string getAge();
-    std::string getEmotion();
-    std::string getGender();
-    void setAge(std::string& age);
-    void setEmotion(std::string& emotion);
-    void setGender(std::string& gender);
-    bool hasAge();
-    bool hasEmotion();
-    bool hasGender();
+    const std::string& getAge() const;
+    const std::string& getEmotion() const;
+    const std::string& getGender() const;
+    void setAge(std::string age);
+    void setEmotion(std::string emotion);
+    void setGender(std::string gender);
+    bool hasAge() const;
+    bool hasEmotion() const;
+    bool hasGender() const;
    private:
     std::string age_;
     std::string emotion_;
@@ -60,23 +63,23 @@ class RecognitionResult {
 
   RecognitionResult(std::string status_string);
   
-  Code getCode() {
+  Code getCode() const {
     return result_status_;
   }
 
-  std::vector<Alternative> getAlternatives() {
+  const std::vector<Alternative>& getAlternatives() const {
     return alternatives_;
   }
 
-  bool isLastSpeechSegment() {
+  bool isLastSpeechSegment() const {
     return last_segment_;
   }
   
-  float startTime(){
+  float startTime() const {
     return start_time_;
   }
   
-  float endTime(){
+  float endTime() const {
     return end_time_;
   }
 
@@ -94,6 +97,12 @@ class RecognitionResult {
 
 
   RecognitionResult& addAlternatives(const Alternative& alt);
+  RecognitionResult& addAlternatives(Alternative&& alt);
+
+  const Classifier& getClassifiers() const {
+    return classfiers_;
+  }
+
   Classifier& getClassifiers() {
     return classfiers_;
   }
@@ -101,9 +110,11 @@ class RecognitionResult {
   static std::string getString(RecognitionResult::Code st);
 
  private:
-  Code result_status_;
+  friend class ASRResultDecoder;
 
-  bool last_segment_;
+  Code result_status_ = Code::NO_MATCH;
+
+  bool last_segment_ = true;
 
   std::vector<Alternative> alternatives_;
   Classifier classfiers_;
@@ -114,7 +125,61 @@ class RecognitionResult {
 
 struct PartialRecognition {
   std::string text_;
-  int speech_segment_index_;
+  int speech_segment_index_ = 0;
+
+  /// Bytes at the start of text_ unchanged since the previous partial
+  /**
+   * Relative to the previous partial delivered for the same speech segment;
+   * 0 on the first partial of a segment. Always at a UTF-8 code point
+   * boundary.
+   */
+  size_t stable_prefix_length_ = 0;
+
+  /// The part of text_ after the stable prefix
+  std::string changed_suffix_;
+};
+
+/// Recognition result body as received from the ASR server
+/**
+ * Delivered to RecognitionListener::onRawRecognitionResult when the
+ * recognizer is built with rawResults(true). The body is an immutable,
+ * reference counted buffer, so it can be handed over to other threads or
+ * forwarded as is without copying. Only the fields needed to route the
+ * result are decoded; the full RecognitionResult is built by materialize().
+ */
+class RawRecognitionResult {
+ public:
+  RawRecognitionResult(std::shared_ptr<const std::string> body,
+                       RecognitionResult::Code code, bool final_result,
+                       int segment_index, bool last_segment);
+
+  /// The JSON body of the result, empty if the server sent none
+  const std::string& getBody() const { return *body_; }
+
+  /// Shared reference to the body buffer
+  std::shared_ptr<const std::string> shareBody() const { return body_; }
+
+  /// Result status, PROCESSING for partial results
+  RecognitionResult::Code getCode() const { return code_; }
+
+  bool isFinal() const { return final_result_; }
+
+  bool isLastSpeechSegment() const { return last_segment_; }
+
+  int getSpeechSegmentIndex() const { return segment_index_; }
+
+  /// Decode the body into a RecognitionResult
+  /**
+   * @throws RecognitionException if the body is not a valid result.
+   */
+  RecognitionResult materialize() const;
+
+ private:
+  std::shared_ptr<const std::string> body_;
+  RecognitionResult::Code code_;
+  bool final_result_;
+  int segment_index_;
+  bool last_segment_;
 };
 
 struct Interpretation {
@@ -131,10 +196,10 @@ struct Word {
 
 class RecognitionResult::Alternative {
  public:
-  int getConfidence();
-  std::string getText();
-  std::vector<Interpretation> getInterpretations();
-  std::vector<Word> getWords();
+  int getConfidence() const;
+  const std::string& getText() const;
+  const std::vector<Interpretation>& getInterpretations() const;
+  const std::vector<Word>& getWords() const;
 
   RecognitionResult::Alternative& languageModel(std::string lang_model);
   RecognitionResult::Alternative& text(std::string text);
@@ -146,6 +211,8 @@ class RecognitionResult::Alternative {
                                           float start_time, float end_time);
 
  private:
+  friend class ASRResultDecoder;
+
   std::string lang_model_;
   std::string text_;
   int confidence_ = 0;
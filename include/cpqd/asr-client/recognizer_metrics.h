@@ -0,0 +1,126 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef INCLUDE_CPQD_ASR_CLIENT_RECOGNIZER_METRICS_H_
+#define INCLUDE_CPQD_ASR_CLIENT_RECOGNIZER_METRICS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/// Snapshot of the runtime counters of a SpeechRecognizer
+struct RecognizerMetrics {
+  /// Listener callbacks waiting to be run
+  size_t callback_queue_depth_ = 0;
+
+  /// Highest number of callbacks waiting at the same time
+  size_t callback_queue_max_depth_ = 0;
+
+  /// Listener callbacks run
+  uint64_t callbacks_ = 0;
+
+  /// Callbacks that ended with an exception
+  uint64_t callback_errors_ = 0;
+
+  /// Total time spent inside listener callbacks
+  std::chrono::microseconds callback_time_{0};
+
+  /// Longest time spent in a single callback
+  std::chrono::microseconds callback_max_time_{0};
+
+  /// Partial results received from the server
+  uint64_t partials_received_ = 0;
+
+  /// Partial results coalesced or filtered out, never delivered
+  uint64_t partials_skipped_ = 0;
+
+  /// Final results waiting to be consumed
+  size_t result_queue_depth_ = 0;
+
+  /// Final results dropped because the result queue was full
+  uint64_t results_dropped_ = 0;
+
+  /// Control messages sent, they are never queued behind audio
+  uint64_t control_messages_ = 0;
+
+  /// Audio messages sent
+  uint64_t audio_messages_ = 0;
+
+  /// Audio sends held back because the connection send queue was full
+  uint64_t audio_stalls_ = 0;
+
+  /// Total time the audio was held back, the audio source is not read
+  std::chrono::microseconds audio_stall_time_{0};
+
+  /// Most bytes seen waiting in the connection send queue
+  size_t send_max_buffered_ = 0;
+
+  /// Connections opened to the server
+  uint64_t connections_ = 0;
+
+  /// Connections found dead by the keepalive or closed by the server
+  uint64_t connections_lost_ = 0;
+
+  /// Pings sent by the keepalive
+  uint64_t pings_ = 0;
+
+  /// Recognitions carried on over a new connection after a lost one
+  uint64_t replays_ = 0;
+
+  /// Audio sent again to the new connections
+  uint64_t replayed_bytes_ = 0;
+
+  /// Recognitions that could be hedged, the hedge rate is hedges_ over it
+  uint64_t hedge_eligible_ = 0;
+
+  /// Recognitions sent to a second server because the result was late
+  uint64_t hedges_ = 0;
+
+  /// Hedged recognitions whose result came from the second server
+  uint64_t hedge_wins_ = 0;
+
+  /// Recognitions rejected with OVERLOADED by the admission control
+  uint64_t admission_rejections_ = 0;
+
+  /// Time the audio was held back by UplinkShaper::global()
+  std::chrono::microseconds uplink_throttled_time_{0};
+
+  /// TLS handshakes completed
+  uint64_t tls_handshakes_ = 0;
+
+  /// TLS handshakes that resumed the session of a previous connection
+  uint64_t tls_resumed_handshakes_ = 0;
+
+  /// Total time spent in TLS handshakes
+  std::chrono::microseconds tls_handshake_time_{0};
+
+  /// Longest TLS handshake
+  std::chrono::microseconds tls_handshake_max_time_{0};
+
+  /// Sessions created on the server, a session lasts many recognitions
+  uint64_t sessions_created_ = 0;
+
+  /// Cancellations acknowledged by the server
+  uint64_t cancels_ = 0;
+
+  /// Time from cancelRecognition() to the server acknowledgement, last one
+  std::chrono::microseconds cancel_latency_{0};
+
+  /// Longest cancellation time
+  std::chrono::microseconds cancel_max_latency_{0};
+};
+
+#endif  // INCLUDE_CPQD_ASR_CLIENT_RECOGNIZER_METRICS_H_
@@ -18,10 +18,14 @@
 #define INCLUDE_CPQD_ASR_CLIENT_SPEECH_RECOG_H_
 
 #include <cpqd/asr-client/audio_source.h>
+#include <cpqd/asr-client/callback_executor.h>
+#include <cpqd/asr-client/completion_queue.h>
+#include <cpqd/asr-client/endpoint_group.h>
 #include <cpqd/asr-client/language_model_list.h>
 #include <cpqd/asr-client/recognition_config.h>
 #include <cpqd/asr-client/recognition_listener.h>
 #include <cpqd/asr-client/recognition_result.h>
+#include <cpqd/asr-client/recognizer_metrics.h>
 
 #include <chrono>
 #include <memory>
@@ -34,6 +38,20 @@ enum class AudioEncoding {
   ULAW,
 };
 
+/// What to do with a final result when the result queue is full
+enum class ResultOverflow {
+  DROP_OLDEST,  // discard the oldest queued result
+  DROP_NEWEST,  // discard the incoming result
+  FAIL,         // fail the recognition
+};
+
+/// How the audio is split into messages
+enum class AudioPacing {
+  AUTO,   // frames follow the backlog of audio not sent yet
+  LIVE,   // shortest frames, for the lowest latency
+  BATCH,  // longest frames, for files and offline jobs
+};
+
 /** @brief SpeechRecognizer class represents an interface between ASR client and
  * server
  *
@@ -58,6 +76,9 @@ class SpeechRecognizer {
     Properties(const Properties& prop) = delete;
 
     std::string url_;
+    std::shared_ptr<EndpointGroup> endpoints_ = nullptr;
+    RecognitionPriority priority_ = RecognitionPriority::NORMAL;
+    std::string tenant_;
     std::string user_;
     std::string passwd_;
     std::string user_agent_;
@@ -65,12 +86,32 @@ class SpeechRecognizer {
     AudioEncoding audio_encoding_;
     std::unique_ptr<RecognitionConfig> recog_config_ = nullptr;
     std::vector<std::unique_ptr<RecognitionListener>> listener_;
+    std::shared_ptr<CallbackExecutor> callback_executor_ = nullptr;
+    unsigned int partial_interval_ms_ = 0;
+    unsigned int partial_min_text_delta_ = 0;
+    unsigned int result_queue_size_ = 256;
+    ResultOverflow result_overflow_ = ResultOverflow::DROP_OLDEST;
+    std::shared_ptr<CompletionQueue> completion_queue_ = nullptr;
+    uint64_t completion_id_ = 0;
+    size_t send_high_water_mark_ = 64 * 1024;
+    AudioPacing audio_pacing_ = AudioPacing::AUTO;
+    unsigned int audio_chunk_min_ms_ = 20;
+    unsigned int audio_chunk_max_ms_ = 1000;
+    bool defer_input_timers_ = false;
+    unsigned int ping_interval_ms_ = 0;
+    unsigned int pong_timeout_ms_ = 5000;
+    unsigned int replay_attempts_ = 0;
+    size_t replay_window_bytes_ = 0;
+    size_t hedge_window_bytes_ = 0;
 
     // Parameters with default values
     unsigned int max_wait_seconds_ = 30;
     bool connect_on_recognize_ = false;
     bool auto_close_ = false;
     std::string log_path_ = "log.txt";
+    bool decode_words_ = true;
+    bool decode_interpretations_ = true;
+    bool raw_results_ = false;
 
     friend class SpeechRecognizer;
     friend class SpeechRecognizer::Builder;
@@ -87,16 +128,105 @@ class SpeechRecognizer {
 
   void cancelRecognition();
 
+  /// End the server session, keeping the connection open
+  /**
+   * The next recognition creates a new session on the same connection,
+   * sending its configuration again.
+   *
+   * @throws RecognitionException if a recognition is running, the server
+   *   refuses the request or does not answer within maxWaitSeconds.
+   */
+  void releaseSession();
+
   void recognize(const std::shared_ptr<AudioSource>& audio_src,
                       std::unique_ptr<LanguageModelList> lm);
 
+  /// Recognize with a shared language model and an optional config
+  /**
+   * A language model shared by many recognitions, e.g. taken from a
+   * LanguageModelRegistry, has its START_RECOGNITION message framed once.
+   *
+   * The config replaces the one given to the Builder for this recognition
+   * only. Only the parameters that differ from the ones already set on the
+   * server session are sent. The config is serialized once, while the same
+   * object is passed again.
+   *
+   * @param [in] config Config of this recognition, nullptr to use the one
+   *   given to the Builder.
+   */
+  void recognize(const std::shared_ptr<AudioSource>& audio_src,
+                 std::shared_ptr<const LanguageModelList> lm,
+                 std::shared_ptr<const RecognitionConfig> config = nullptr);
+
+  /// Arm a recognition ahead of its audio
+  /**
+   * Creates the session, sets the parameters and starts the recognition on
+   * the server, without waiting for the responses. The recognizer is then
+   * on standby: the audio given to recognize(audio_src) later goes out
+   * with no protocol round trip.
+   *
+   * A prepared recognition is running: it can be canceled, and recognize()
+   * with a language model throws until it ends.
+   */
+  void prepareRecognition(
+      std::shared_ptr<const LanguageModelList> lm,
+      std::shared_ptr<const RecognitionConfig> config = nullptr);
+
+  /// Whether the server acknowledged the prepared recognition
+  bool isArmed() const;
+
+  /// Feed audio to the recognition armed by prepareRecognition()
+  /**
+   * @throws RecognitionException if no recognition was prepared.
+   */
+  void recognize(const std::shared_ptr<AudioSource>& audio_src);
+
+  /// Start the no-input and recognition timers of the running recognition
+  /**
+   * Meant for barge-in: the recognition runs while a prompt is played and
+   * the timers start when the playback ends. Requires the input timers to
+   * be kept stopped, see Builder::deferInputTimers().
+   *
+   * Called before the server acknowledged the recognition, the request is
+   * sent right after the acknowledgement.
+   *
+   * @throws RecognitionException if no recognition is running.
+   */
+  void startInputTimers();
+
   std::vector<RecognitionResult> waitRecognitionResult();
 
+  /// Take the next final result of the current recognition
+  /**
+   * Results are queued as they arrive, so in continuous mode each segment
+   * can be consumed as soon as it is recognized:
+   *
+   *     RecognitionResult result;
+   *     while (recognizer->nextResult(result, std::chrono::seconds(30))) {
+   *       ...
+   *     }
+   *
+   * @param [out] result The oldest result not consumed yet.
+   * @param [in] timeout Maximum time to wait for a result.
+   * @return false once the recognition has ended and all its results were
+   *   consumed.
+   * @throws RecognitionException on recognition errors and on timeout.
+   */
+  bool nextResult(RecognitionResult& result, std::chrono::milliseconds timeout);
+
   bool isOpen(); // For testing purposes
 
+  /// Snapshot of the recognizer runtime counters
+  RecognizerMetrics getMetrics() const;
+
  private:
   explicit SpeechRecognizer(std::unique_ptr<Properties> properties);
 
+  /// Start the protocol of a recognition, the audio may come later
+  void beginRecognition(const std::shared_ptr<AudioSource>& audio_src,
+                        std::shared_ptr<const LanguageModelList> lm,
+                        std::shared_ptr<const RecognitionConfig> config);
+
   std::shared_ptr<Impl> impl_ = nullptr;
 
   std::unique_ptr<Properties> properties_ = nullptr;
@@ -115,6 +245,23 @@ class SpeechRecognizer::Builder {
   std::unique_ptr<SpeechRecognizer> build();
 
   SpeechRecognizer::Builder& serverUrl(const std::string& url);
+
+  /// Pick the server from a group on every connection, ignoring serverUrl()
+  /**
+   * @param [in] group Servers shared with other recognizers. The
+   *   Channel-Identifier of recogConfig() routes the CHANNEL_AFFINITY policy.
+   */
+  SpeechRecognizer::Builder& endpoints(std::shared_ptr<EndpointGroup> group);
+
+  /// Class of the recognitions waiting for a slot of the endpoints() group
+  SpeechRecognizer::Builder& priority(RecognitionPriority priority);
+
+  /// Fair queuing key of the recognitions waiting for a slot
+  /**
+   * By default the Account-Tag of the RecognitionConfig of the
+   * recognition, or of recogConfig().
+   */
+  SpeechRecognizer::Builder& tenant(const std::string& tenant);
   SpeechRecognizer::Builder& credentials(const std::string& user,
                                          const std::string& passwd);
   SpeechRecognizer::Builder& recogConfig(
@@ -128,6 +275,95 @@ class SpeechRecognizer::Builder {
   SpeechRecognizer::Builder& connectOnRecognize(bool value);
   SpeechRecognizer::Builder& autoClose(bool value);
   SpeechRecognizer::Builder& logPath(std::string value);
+  SpeechRecognizer::Builder& decodeWords(bool value);
+  SpeechRecognizer::Builder& decodeInterpretations(bool value);
+  SpeechRecognizer::Builder& rawResults(bool value);
+  SpeechRecognizer::Builder& callbackExecutor(
+      std::shared_ptr<CallbackExecutor> executor);
+
+  /// Deliver at most one partial result per interval, the latest one
+  SpeechRecognizer::Builder& partialResultInterval(unsigned int milliseconds);
+
+  /// Drop partial results that change less than this many characters
+  SpeechRecognizer::Builder& partialMinTextDelta(unsigned int characters);
+
+  /// Maximum number of final results waiting to be consumed
+  SpeechRecognizer::Builder& resultQueueSize(unsigned int value);
+  SpeechRecognizer::Builder& resultQueueOverflow(ResultOverflow value);
+
+  /// Post the outcome of every recognition to a completion queue
+  /**
+   * @param [in] queue Queue shared with other recognizers.
+   * @param [in] id Identifies this recognizer in the queue events.
+   */
+  SpeechRecognizer::Builder& completionQueue(
+      std::shared_ptr<CompletionQueue> queue, uint64_t id);
+
+  /// Bytes the connection may hold before audio sending pauses
+  /**
+   * While the connection send queue is above this mark the audio source is
+   * not read. Time spent paused is reported by getMetrics().
+   */
+  SpeechRecognizer::Builder& sendHighWaterMark(size_t bytes);
+
+  /// Duration bounds of the audio messages, in milliseconds
+  SpeechRecognizer::Builder& audioChunkDuration(unsigned int min_ms,
+                                                unsigned int max_ms);
+  SpeechRecognizer::Builder& audioPacing(AudioPacing value);
+
+  /// Keep the input timers stopped until startInputTimers() is called
+  /**
+   * Overrides the startInputTimers field of every recognition config.
+   */
+  SpeechRecognizer::Builder& deferInputTimers(bool value);
+
+  /// Ping the server to find out dead connections
+  /**
+   * A connection that received nothing for the ping interval is pinged,
+   * and declared dead when the pong takes longer than the pong timeout.
+   * While a recognition runs the connection is pinged after a pong timeout
+   * of silence, so a dead connection fails the recognition with
+   * CONNECTION_FAILURE in about two pong timeouts. A dead idle connection
+   * is replaced by the next recognition. Disabled by default.
+   *
+   * @param [in] ping_interval_ms 0 disables the keepalive.
+   * @param [in] pong_timeout_ms Longer than the round trip time and the
+   *   busiest response time of the server, a few seconds.
+   */
+  SpeechRecognizer::Builder& keepAlive(unsigned int ping_interval_ms,
+                                       unsigned int pong_timeout_ms);
+
+  /// Carry a recognition on over a new connection when its connection dies
+  /**
+   * The audio of the current utterance is kept. When the connection is
+   * lost the recognizer reconnects, with a jittered exponential backoff,
+   * creates a new session with the same parameters and sends the audio
+   * again at full speed, before the rest of the audio source. The
+   * application only sees the result arriving later.
+   *
+   * The audio of segments already recognized is not sent again. A
+   * recognition whose utterance outgrows the window fails as usual.
+   *
+   * @param [in] max_attempts Connections tried per recognition, 0 disables.
+   * @param [in] window_bytes Audio kept, e.g. 16000 bytes per second of
+   *   8 kHz linear PCM.
+   */
+  SpeechRecognizer::Builder& replayOnConnectionLoss(unsigned int max_attempts,
+                                                    size_t window_bytes);
+
+  /// Send a late recognition to a second server of the endpoints() group
+  /**
+   * When the last final result has not arrived some time after the end of
+   * the audio, the same audio and language model go to another server of
+   * the group too. The first final result wins, the other recognition is
+   * canceled. The delay is a percentile of the latencies seen by the group
+   * and the hedges are capped by a budget, both set in
+   * EndpointGroup::Options.
+   *
+   * @param [in] window_bytes Audio kept to be sent again, a longer
+   *   utterance is not hedged.
+   */
+  SpeechRecognizer::Builder& hedgeRecognitions(size_t window_bytes);
 
  private:
   std::unique_ptr<SpeechRecognizer::Properties> properties_ = nullptr;
@@ -0,0 +1,135 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef INCLUDE_CPQD_ASR_CLIENT_UPLINK_SHAPER_H_
+#define INCLUDE_CPQD_ASR_CLIENT_UPLINK_SHAPER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/// Kind of the audio sent to the servers
+enum class UplinkClass {
+  /// Audio paced by its source, in real time
+  LIVE,
+
+  /// Audio sent faster than real time: BATCH pacing, replays and hedges
+  BULK,
+};
+
+/// Bandwidth limit of the audio sent by every recognizer of the process
+/**
+ * Recognizers take tokens from the shaper before sending each audio
+ * message. Live and bulk audio have separate token buckets, so that
+ * accelerated batch jobs running in the background can't take the uplink
+ * of live calls:
+ *
+ *     UplinkShaper::Options options;
+ *     options.bulk_rate_ = 4 * 1024 * 1024;
+ *     UplinkShaper::global().configure(options);
+ *
+ * A message larger than the tokens left is held back until the bucket
+ * refills the difference. The bucket of a class without a rate never holds
+ * anything back, which is the default.
+ */
+class UplinkShaper {
+ public:
+  struct Options {
+    /// Bytes per second of live audio, 0 for no limit
+    size_t live_rate_ = 0;
+
+    /// Bytes sent at once after the live audio was idle
+    size_t live_burst_ = 64 * 1024;
+
+    /// Bytes per second of bulk audio, 0 for no limit
+    size_t bulk_rate_ = 0;
+
+    /// Bytes sent at once after the bulk audio was idle
+    size_t bulk_burst_ = 64 * 1024;
+  };
+
+  /// Counters of a class of audio
+  struct Stats {
+    /// Bytes sent
+    uint64_t bytes_ = 0;
+
+    /// Throughput, averaged over about a second
+    double bytes_per_second_ = 0;
+
+    /// Messages held back by the bucket
+    uint64_t throttles_ = 0;
+
+    /// Total time messages were held back
+    std::chrono::microseconds throttled_time_{0};
+  };
+
+  UplinkShaper() = default;
+
+  /**
+   * @throws std::invalid_argument if a rate is set without a burst.
+   */
+  explicit UplinkShaper(const Options& options);
+
+  UplinkShaper(const UplinkShaper&) = delete;
+  UplinkShaper& operator=(const UplinkShaper&) = delete;
+
+  /// Shaper consulted by every recognizer
+  static UplinkShaper& global();
+
+  /// Replace the rates, the buckets start full
+  /**
+   * @throws std::invalid_argument if a rate is set without a burst.
+   */
+  void configure(const Options& options);
+
+  /// Take the tokens of a message about to be sent
+  /**
+   * @return How long to hold the message back, zero to send it now.
+   */
+  std::chrono::microseconds reserve(UplinkClass uplink, size_t bytes);
+
+  Stats stats(UplinkClass uplink);
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  // Time constant of the throughput average, in seconds
+  static const int kMeterSeconds = 1;
+
+  struct Bucket {
+    double rate = 0;
+    double burst = 0;
+    // negative while messages are held back
+    double tokens = 0;
+    Clock::time_point refilled;
+
+    // bytes sent, decayed with the meter time constant
+    double meter = 0;
+    Clock::time_point metered;
+
+    Stats stats;
+  };
+
+  Bucket& bucket(UplinkClass uplink);
+  void decay(Bucket& bucket, Clock::time_point now);
+
+  std::mutex lock_;
+  Bucket live_;
+  Bucket bulk_;
+};
+
+#endif  // INCLUDE_CPQD_ASR_CLIENT_UPLINK_SHAPER_H_
@@ -16,4 +16,46 @@
 
 #include "src/asr_message_request.h"
 
+#include <cpqd/asr-client/recognition_exception.h>
+
 ASRMessageRequest::ASRMessageRequest(Method c) { start_line_ = firstLine(c); }
+
+std::shared_ptr<const std::string> ASRMessageRequest::startRecognition(
+    const LanguageModelList& lm) {
+  std::shared_ptr<const std::string> cached =
+      std::atomic_load(&lm.start_message_);
+  if (cached) return cached;
+
+  ASRMessageRequest request(Method::StartRecognition);
+  request.set_header("Accept", "application/json");
+
+  // if lm property uri and grammar body was not set, throw an error
+  const std::string& lm_uri = lm.getUri();
+  const std::string& grammar_body = lm.getGrammarBody();
+  std::string content_type;
+  size_t size;
+  if (!lm_uri.empty()) {
+    request.extra_ = lm_uri;
+    content_type = "text/uri-list";
+    size = lm_uri.size();
+  } else if (!grammar_body.empty()) {
+    request.extra_ = grammar_body;
+    content_type = "application/srgs";
+    size = grammar_body.size();
+
+    // only one grammar is allowed, so the id is fixed by now
+    request.set_header("Content-ID", "gram");
+  } else {
+    throw RecognitionException(RecognitionError::Code::FAILURE,
+        std::string("lm uri and grammar body is emprty"));
+  }
+
+  request.set_header("Content-Type", content_type);
+  request.set_header("Content-Length", std::to_string(size));
+
+  // Recognitions racing on a new model may frame it more than once, the
+  // messages are identical
+  cached = std::make_shared<const std::string>(request.raw());
+  std::atomic_store(&lm.start_message_, cached);
+  return cached;
+}
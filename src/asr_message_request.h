@@ -17,6 +17,9 @@
 #ifndef SRC_ASR_MESSAGE_REQUEST_H_
 #define SRC_ASR_MESSAGE_REQUEST_H_
 
+#include <cpqd/asr-client/language_model_list.h>
+
+#include <memory>
 #include <string>
 
 #include "src/asr_message_parser.h"
@@ -26,6 +29,16 @@ class ASRMessageRequest : public ASRMessageParser {
  public:
   explicit ASRMessageRequest(Method c);
 
+  /// START_RECOGNITION message of a language model, ready to send
+  /**
+   * The message is framed once and cached in the model, so a model shared
+   * by many recognitions is never serialized again.
+   *
+   * @throws RecognitionException if the model has no URI nor grammar.
+   */
+  static std::shared_ptr<const std::string> startRecognition(
+      const LanguageModelList& lm);
+
   /// Set a value for an ASR Message header, replacing an existing value
   /**
    * This method will set the value of the ASR Message header `key` with the
@@ -38,19 +38,17 @@ void removeExtraSpaces(std::string& input) {
 }  // namespace internal
 
 void ASRMessageResponse::consume(const std::string& payload) {
-  std::string msg_body = payload;
-  std::string msg_extra;
-
   cpqd::WsParser parser(payload);
   headers_ = parser.GetParams();
   extra_ = parser.GetBody();
   start_line_ = "ASR 2.4 " + parser.GetCmd();
-  auto start = 0U;
-  auto end = payload.find(hdr_delimiter);
+  shared_extra_ = nullptr;
+}
 
-  // search for empty line
-  if (end != std::string::npos) {
-    msg_body = payload.substr(start, end - start);
-    msg_extra = payload.substr(end + hdr_delimiter.length());
+std::shared_ptr<const std::string> ASRMessageResponse::share_extra() {
+  if (!shared_extra_) {
+    shared_extra_ = std::make_shared<const std::string>(std::move(extra_));
+    extra_.clear();
   }
+  return shared_extra_;
 }
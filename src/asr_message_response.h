@@ -17,6 +17,7 @@
 #ifndef SRC_ASR_MESSAGE_RESPONSE_H_
 #define SRC_ASR_MESSAGE_RESPONSE_H_
 
+#include <memory>
 #include <string>
 
 #include "src/asr_message_parser.h"
@@ -30,6 +31,24 @@ class ASRMessageResponse : public ASRMessageParser {
  * @param payload raw message content.
  */
   void consume(const std::string& payload);
+
+  /// Get ASR Message body
+  /**
+   * @return The body of the ASR Message, also after share_extra().
+   */
+  const std::string& get_extra() const {
+    return shared_extra_ ? *shared_extra_ : extra_;
+  }
+
+  /// Get the ASR Message body as an immutable, reference counted buffer
+  /**
+   * The body is moved into the buffer on the first call, so it may outlive
+   * the message without being copied.
+   */
+  std::shared_ptr<const std::string> share_extra();
+
+ private:
+  std::shared_ptr<const std::string> shared_extra_;
 };
 
 #endif  // SRC_ASR_MESSAGE_RESPONSE_H_
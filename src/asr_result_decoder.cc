@@ -0,0 +1,601 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include "src/asr_result_decoder.h"
+
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+namespace {
+
+// Nesting limit for skipped subtrees, protects the stack against hostile
+// payloads
+const int kMaxDepth = 64;
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+void appendUtf8(std::string& out, uint32_t cp) {
+  if (cp < 0x80) {
+    out.push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else if (cp < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  }
+}
+
+}  // namespace
+
+bool ASRResultDecoder::decode(const std::string& body, Routing& routing,
+                              RecognitionResult& result) {
+  return decodeBody(body, Mode::kFull, routing, &result, nullptr);
+}
+
+bool ASRResultDecoder::materialize(const RawRecognitionResult& raw,
+                                   RecognitionResult& result) {
+  result = RecognitionResult(
+      raw.getCode() == RecognitionResult::Code::PROCESSING
+          ? RecognitionResult::Code::NO_MATCH : raw.getCode());
+  if (!raw.getBody().empty()) {
+    Routing routing;
+    if (!decode(raw.getBody(), routing, result)) return false;
+  }
+  result.setLastSpeechSegment(raw.isLastSpeechSegment());
+  return true;
+}
+
+bool ASRResultDecoder::decodePartial(const std::string& body, Routing& routing,
+                                     PartialRecognition& partial) {
+  return decodeBody(body, Mode::kPartial, routing, nullptr, &partial);
+}
+
+bool ASRResultDecoder::scan(const std::string& body, Routing& routing) {
+  return decodeBody(body, Mode::kScan, routing, nullptr, nullptr);
+}
+
+void ASRResultDecoder::toPartial(const Routing& routing,
+                                 RecognitionResult& result,
+                                 PartialRecognition& partial) {
+  partial.text_.clear();
+  if (!result.alternatives_.empty())
+    partial.text_ = std::move(result.alternatives_.front().text_);
+  partial.speech_segment_index_ = routing.segment_index;
+}
+
+bool ASRResultDecoder::decodeBody(const std::string& body, Mode mode,
+                                  Routing& routing, RecognitionResult* result,
+                                  PartialRecognition* partial) {
+  cur_ = body.data();
+  end_ = cur_ + body.size();
+  failed_ = false;
+  routing = Routing();
+
+  if (!consume('{')) return false;
+
+  bool first = true;
+  while (nextMember(first)) {
+    if (key_ == "alternatives") {
+      decodeAlternatives(mode, result, partial);
+    } else if (key_ == "result_status") {
+      tryString(routing.result_status);
+    } else if (key_ == "final_result") {
+      routing.has_final_result = tryBool(routing.final_result);
+    } else if (key_ == "last_segment") {
+      routing.has_last_segment = tryBool(routing.last_segment);
+    } else if (key_ == "segment_index") {
+      tryInt(routing.segment_index);
+    } else if (key_ == "start_time") {
+      double value;
+      routing.has_start_time = tryNumber(value);
+      if (routing.has_start_time)
+        routing.start_time = static_cast<float>(value);
+    } else if (key_ == "end_time") {
+      double value;
+      routing.has_end_time = tryNumber(value);
+      if (routing.has_end_time) routing.end_time = static_cast<float>(value);
+    } else if (mode == Mode::kFull && options_.classifiers &&
+               key_ == "age_scores") {
+      std::string age;
+      if (decodeScores("age", age)) result->classfiers_.setAge(std::move(age));
+    } else if (mode == Mode::kFull && options_.classifiers &&
+               key_ == "emotion_scores") {
+      std::string emotion;
+      if (decodeScores("emotion", emotion))
+        result->classfiers_.setEmotion(std::move(emotion));
+    } else if (mode == Mode::kFull && options_.classifiers &&
+               key_ == "gender_scores") {
+      std::string gender;
+      if (decodeScores("gender", gender))
+        result->classfiers_.setGender(std::move(gender));
+    } else {
+      skipValue();
+    }
+    if (failed_) return false;
+  }
+  if (failed_) return false;
+
+  if (mode == Mode::kFull) {
+    result->result_status_ = RecognitionResult(routing.result_status).getCode();
+    if (!result->alternatives_.empty() &&
+        result->result_status_ == RecognitionResult::Code::NO_MATCH)
+      result->result_status_ = RecognitionResult::Code::RECOGNIZED;
+    result->last_segment_ = routing.last_segment;
+    if (routing.has_start_time) result->start_time_ = routing.start_time;
+    if (routing.has_end_time) result->end_time_ = routing.end_time;
+  } else if (mode == Mode::kPartial) {
+    partial->speech_segment_index_ = routing.segment_index;
+  }
+  return true;
+}
+
+void ASRResultDecoder::decodeAlternatives(Mode mode, RecognitionResult* result,
+                                          PartialRecognition* partial) {
+  skipSpaces();
+  if (mode == Mode::kScan || !peek('[')) {
+    skipValue();
+    return;
+  }
+  consume('[');
+
+  if (mode == Mode::kPartial) partial->text_.clear();
+
+  bool first = true;
+  bool first_alternative = true;
+  while (nextElement(first)) {
+    if (mode == Mode::kFull) {
+      result->alternatives_.emplace_back();
+      decodeAlternative(result->alternatives_.back());
+    } else if (first_alternative && peek('{')) {
+      // Partial results only carry the text of the best hypothesis
+      consume('{');
+      bool first_member = true;
+      while (nextMember(first_member)) {
+        if (key_ == "text")
+          tryString(partial->text_);
+        else
+          skipValue();
+      }
+    } else {
+      skipValue();
+    }
+    first_alternative = false;
+    if (failed_) return;
+  }
+}
+
+void ASRResultDecoder::decodeAlternative(
+    RecognitionResult::Alternative& alt) {
+  if (!peek('{')) {
+    skipValue();
+    return;
+  }
+  consume('{');
+
+  bool first = true;
+  while (nextMember(first)) {
+    if (key_ == "text") {
+      tryString(alt.text_);
+    } else if (key_ == "score") {
+      tryInt(alt.confidence_);
+    } else if (key_ == "interpretations" && options_.interpretations) {
+      decodeInterpretations(alt);
+    } else if (key_ == "words" && options_.words) {
+      decodeWords(alt);
+    } else {
+      skipValue();
+    }
+    if (failed_) return;
+  }
+}
+
+void ASRResultDecoder::decodeInterpretations(
+    RecognitionResult::Alternative& alt) {
+  if (!peek('[')) {
+    skipValue();
+    return;
+  }
+  consume('[');
+
+  bool first = true;
+  while (nextElement(first)) {
+    alt.interpretations_.emplace_back();
+    Interpretation& interp = alt.interpretations_.back();
+    interp.confidence_ = 0;
+    if (peek('"')) {
+      readString(interp.text_);
+    } else {
+      // Semantic interpretations may be JSON objects, keep their raw text
+      const char* start = cur_;
+      skipValue();
+      interp.text_.assign(start, cur_);
+    }
+    if (failed_) return;
+  }
+}
+
+void ASRResultDecoder::decodeWords(RecognitionResult::Alternative& alt) {
+  if (!peek('[')) {
+    skipValue();
+    return;
+  }
+  consume('[');
+
+  bool first = true;
+  while (nextElement(first)) {
+    if (!peek('{')) {
+      skipValue();
+    } else {
+      alt.words_.emplace_back();
+      decodeWord(alt.words_.back());
+    }
+    if (failed_) return;
+  }
+}
+
+void ASRResultDecoder::decodeWord(Word& word) {
+  consume('{');
+
+  bool first = true;
+  while (nextMember(first)) {
+    double value;
+    if (key_ == "text") {
+      tryString(word.text_);
+    } else if (key_ == "score") {
+      tryInt(word.confidence_);
+    } else if (key_ == "start_time") {
+      if (tryNumber(value)) word.start_time_ = static_cast<float>(value);
+    } else if (key_ == "end_time") {
+      if (tryNumber(value)) word.end_time_ = static_cast<float>(value);
+    } else {
+      skipValue();
+    }
+    if (failed_) return;
+  }
+}
+
+bool ASRResultDecoder::decodeScores(const char* name, std::string& value) {
+  if (!peek('{')) {
+    skipValue();
+    return false;
+  }
+  consume('{');
+
+  bool found = false;
+  bool first = true;
+  while (nextMember(first)) {
+    if (key_ != name) {
+      skipValue();
+    } else if (peek('"')) {
+      found = readString(value);
+    } else {
+      double number;
+      found = tryNumber(number);
+      if (found) value = std::to_string(number);
+    }
+    if (failed_) return false;
+  }
+  return found;
+}
+
+void ASRResultDecoder::skipSpaces() {
+  while (cur_ < end_ && isSpace(*cur_)) ++cur_;
+}
+
+bool ASRResultDecoder::consume(char c) {
+  skipSpaces();
+  if (cur_ < end_ && *cur_ == c) {
+    ++cur_;
+    return true;
+  }
+  failed_ = true;
+  return false;
+}
+
+bool ASRResultDecoder::peek(char c) {
+  skipSpaces();
+  return cur_ < end_ && *cur_ == c;
+}
+
+bool ASRResultDecoder::nextMember(bool& first) {
+  if (failed_) return false;
+  skipSpaces();
+  if (cur_ < end_ && *cur_ == '}') {
+    ++cur_;
+    return false;
+  }
+  if (!first && !consume(',')) return false;
+  first = false;
+  if (!peek('"')) {
+    failed_ = true;
+    return false;
+  }
+  return readString(key_) && consume(':');
+}
+
+bool ASRResultDecoder::nextElement(bool& first) {
+  if (failed_) return false;
+  skipSpaces();
+  if (cur_ < end_ && *cur_ == ']') {
+    ++cur_;
+    return false;
+  }
+  if (!first && !consume(',')) return false;
+  first = false;
+  skipSpaces();
+  return true;
+}
+
+bool ASRResultDecoder::readString(std::string& out) {
+  if (!consume('"')) return false;
+  out.clear();
+
+  while (cur_ < end_) {
+    // copy unescaped runs at once
+    const char* run = cur_;
+    while (cur_ < end_ && *cur_ != '"' && *cur_ != '\\') ++cur_;
+    out.append(run, cur_);
+    if (cur_ >= end_) break;
+
+    if (*cur_ == '"') {
+      ++cur_;
+      return true;
+    }
+
+    // escape sequence
+    if (++cur_ >= end_) break;
+    char esc = *cur_++;
+    switch (esc) {
+      case '"':  out.push_back('"');  break;
+      case '\\': out.push_back('\\'); break;
+      case '/':  out.push_back('/');  break;
+      case 'b':  out.push_back('\b'); break;
+      case 'f':  out.push_back('\f'); break;
+      case 'n':  out.push_back('\n'); break;
+      case 'r':  out.push_back('\r'); break;
+      case 't':  out.push_back('\t'); break;
+      case 'u': {
+        uint32_t cp = 0;
+        if (!readHex4(cp)) return false;
+        // surrogate pair
+        if (cp >= 0xD800 && cp <= 0xDBFF && end_ - cur_ >= 6 &&
+            cur_[0] == '\\' && cur_[1] == 'u') {
+          cur_ += 2;
+          uint32_t low = 0;
+          if (!readHex4(low)) return false;
+          if (low >= 0xDC00 && low <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+          } else {
+            appendUtf8(out, cp);
+            cp = low;
+          }
+        }
+        appendUtf8(out, cp);
+        break;
+      }
+      default:
+        failed_ = true;
+        return false;
+    }
+  }
+  // unterminated string
+  failed_ = true;
+  return false;
+}
+
+bool ASRResultDecoder::readHex4(uint32_t& cp) {
+  if (end_ - cur_ < 4) {
+    failed_ = true;
+    return false;
+  }
+  for (int i = 0; i < 4; ++i) {
+    int v = hexValue(*cur_++);
+    if (v < 0) {
+      failed_ = true;
+      return false;
+    }
+    cp = (cp << 4) | static_cast<uint32_t>(v);
+  }
+  return true;
+}
+
+bool ASRResultDecoder::skipString() {
+  if (!consume('"')) return false;
+  while (cur_ < end_) {
+    char c = *cur_++;
+    if (c == '"') return true;
+    if (c == '\\' && cur_ < end_) ++cur_;
+  }
+  failed_ = true;
+  return false;
+}
+
+bool ASRResultDecoder::readNumber(double& out) {
+  // Locale independent parser, strtod would honour LC_NUMERIC
+  skipSpaces();
+  bool negative = false;
+  if (cur_ < end_ && *cur_ == '-') {
+    negative = true;
+    ++cur_;
+  }
+  if (cur_ >= end_ || !isDigit(*cur_)) {
+    failed_ = true;
+    return false;
+  }
+
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  for (; cur_ < end_ && isDigit(*cur_); ++cur_) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*cur_ - '0');
+      if (mantissa) ++digits;
+    } else {
+      ++exponent;
+    }
+  }
+  if (cur_ < end_ && *cur_ == '.') {
+    ++cur_;
+    if (cur_ >= end_ || !isDigit(*cur_)) {
+      failed_ = true;
+      return false;
+    }
+    for (; cur_ < end_ && isDigit(*cur_); ++cur_) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*cur_ - '0');
+        if (mantissa) ++digits;
+        --exponent;
+      }
+    }
+  }
+  if (cur_ < end_ && (*cur_ == 'e' || *cur_ == 'E')) {
+    ++cur_;
+    bool exp_negative = false;
+    if (cur_ < end_ && (*cur_ == '+' || *cur_ == '-')) {
+      exp_negative = *cur_ == '-';
+      ++cur_;
+    }
+    if (cur_ >= end_ || !isDigit(*cur_)) {
+      failed_ = true;
+      return false;
+    }
+    int exp_value = 0;
+    for (; cur_ < end_ && isDigit(*cur_); ++cur_) {
+      if (exp_value < 10000) exp_value = exp_value * 10 + (*cur_ - '0');
+    }
+    exponent += exp_negative ? -exp_value : exp_value;
+  }
+
+  out = static_cast<double>(mantissa);
+  if (exponent < 0)
+    out /= std::pow(10.0, -exponent);
+  else if (exponent > 0)
+    out *= std::pow(10.0, exponent);
+  if (negative) out = -out;
+  return true;
+}
+
+bool ASRResultDecoder::tryString(std::string& out) {
+  if (peek('"')) return readString(out);
+  skipValue();
+  return false;
+}
+
+bool ASRResultDecoder::tryNumber(double& out) {
+  skipSpaces();
+  if (cur_ < end_ && (*cur_ == '-' || isDigit(*cur_))) return readNumber(out);
+  skipValue();
+  return false;
+}
+
+bool ASRResultDecoder::tryInt(int& out) {
+  double value;
+  if (!tryNumber(value)) return false;
+  // converting anything else to int is undefined
+  if (!(value >= INT_MIN && value <= INT_MAX) || std::trunc(value) != value) {
+    failed_ = true;
+    return false;
+  }
+  out = static_cast<int>(value);
+  return true;
+}
+
+bool ASRResultDecoder::tryBool(bool& out) {
+  skipSpaces();
+  if (matchLiteral("true", 4)) {
+    out = true;
+    return true;
+  }
+  if (matchLiteral("false", 5)) {
+    out = false;
+    return true;
+  }
+  skipValue();
+  return false;
+}
+
+bool ASRResultDecoder::matchLiteral(const char* literal, size_t size) {
+  if (static_cast<size_t>(end_ - cur_) < size ||
+      std::char_traits<char>::compare(cur_, literal, size) != 0)
+    return false;
+  cur_ += size;
+  return true;
+}
+
+bool ASRResultDecoder::skipValue(int depth) {
+  if (depth > kMaxDepth) {
+    failed_ = true;
+    return false;
+  }
+  skipSpaces();
+  if (cur_ >= end_) {
+    failed_ = true;
+    return false;
+  }
+
+  switch (*cur_) {
+    case '"':
+      return skipString();
+    case '{': {
+      ++cur_;
+      bool first = true;
+      while (nextMember(first)) {
+        if (!skipValue(depth + 1)) return false;
+      }
+      return !failed_;
+    }
+    case '[': {
+      ++cur_;
+      bool first = true;
+      while (nextElement(first)) {
+        if (!skipValue(depth + 1)) return false;
+      }
+      return !failed_;
+    }
+    case 't':
+    case 'f':
+    case 'n':
+      if (matchLiteral("true", 4) || matchLiteral("false", 5) ||
+          matchLiteral("null", 4))
+        return true;
+      failed_ = true;
+      return false;
+    default: {
+      double value;
+      return readNumber(value);
+    }
+  }
+}
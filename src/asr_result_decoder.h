@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef SRC_ASR_RESULT_DECODER_H_
+#define SRC_ASR_RESULT_DECODER_H_
+
+#include <cpqd/asr-client/recognition_result.h>
+
+#include <cstdint>
+#include <string>
+
+/// Single pass decoder for RECOGNITION_RESULT message bodies
+/**
+ * Reads the JSON body sent by the ASR server and fills a RecognitionResult
+ * directly, without building an intermediate document. Subtrees the
+ * application is not interested in (word timings, interpretations) are
+ * skipped by the tokenizer instead of being materialized.
+ *
+ * A decoder instance keeps a scratch buffer for object keys, so reusing the
+ * same instance for every message of a connection avoids most allocations.
+ * Instances are not thread safe.
+ */
+class ASRResultDecoder {
+ public:
+  struct Options {
+    /// Decode the "words" array of each alternative
+    bool words = true;
+
+    /// Decode the "interpretations" array of each alternative
+    bool interpretations = true;
+
+    /// Decode age, emotion and gender classifier scores
+    bool classifiers = true;
+  };
+
+  /// Fields used to route a result message, available on every decode
+  struct Routing {
+    std::string result_status;
+
+    bool has_final_result = false;
+    bool final_result = false;
+
+    bool has_last_segment = false;
+    bool last_segment = true;
+
+    // Default segment index is 0 (pre-3.0)
+    int segment_index = 0;
+
+    bool has_start_time = false;
+    float start_time = -1;
+
+    bool has_end_time = false;
+    float end_time = -1;
+  };
+
+  ASRResultDecoder() = default;
+
+  explicit ASRResultDecoder(const Options& options) : options_(options) {}
+
+  const Options& options() const { return options_; }
+
+  /// Decode a final result
+  /**
+   * @param [in] body The JSON body of the RECOGNITION_RESULT message.
+   * @param [out] routing Routing fields found in the body.
+   * @param [out] result Result filled with the alternatives and classifiers.
+   * @return false if the body is not a valid JSON object.
+   */
+  bool decode(const std::string& body, Routing& routing,
+              RecognitionResult& result);
+
+  /// Build the full result of a raw one
+  /**
+   * @return false if the body is not a valid JSON object.
+   */
+  bool materialize(const RawRecognitionResult& raw, RecognitionResult& result);
+
+  /// Decode a partial result
+  /**
+   * Only the text of the first alternative is materialized, every other
+   * subtree of the alternatives array is skipped.
+   *
+   * @return false if the body is not a valid JSON object.
+   */
+  bool decodePartial(const std::string& body, Routing& routing,
+                     PartialRecognition& partial);
+
+  /// Read only the routing fields, skipping the alternatives entirely
+  /**
+   * @return false if the body is not a valid JSON object.
+   */
+  bool scan(const std::string& body, Routing& routing);
+
+  /// Turn a result decoded with decode() into a partial result
+  /**
+   * The text of the best alternative is moved out of `result`.
+   */
+  static void toPartial(const Routing& routing, RecognitionResult& result,
+                        PartialRecognition& partial);
+
+ private:
+  enum class Mode { kFull, kPartial, kScan };
+
+  bool decodeBody(const std::string& body, Mode mode, Routing& routing,
+                  RecognitionResult* result, PartialRecognition* partial);
+
+  void decodeAlternatives(Mode mode, RecognitionResult* result,
+                          PartialRecognition* partial);
+  void decodeAlternative(RecognitionResult::Alternative& alt);
+  void decodeInterpretations(RecognitionResult::Alternative& alt);
+  void decodeWords(RecognitionResult::Alternative& alt);
+  void decodeWord(Word& word);
+  bool decodeScores(const char* name, std::string& value);
+
+  // Tokenizer primitives. Malformed input sets failed_ and makes every
+  // following call return false.
+  void skipSpaces();
+  bool consume(char c);
+  bool peek(char c);
+  bool matchLiteral(const char* literal, size_t size);
+  bool nextMember(bool& first);
+  bool nextElement(bool& first);
+  bool readString(std::string& out);
+  bool readHex4(uint32_t& cp);
+  bool readNumber(double& out);
+  bool skipString();
+  bool skipValue(int depth = 0);
+
+  // Typed readers: when the next value has another type it is skipped and
+  // false is returned, mirroring the lenient accessors of a JSON document
+  bool tryString(std::string& out);
+  bool tryNumber(double& out);
+  // a number that is not an int makes the body invalid
+  bool tryInt(int& out);
+  bool tryBool(bool& out);
+
+  Options options_;
+
+  const char* cur_ = nullptr;
+  const char* end_ = nullptr;
+  bool failed_ = false;
+
+  // object keys are read into this buffer, reused between messages
+  std::string key_;
+};
+
+#endif  // SRC_ASR_RESULT_DECODER_H_
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef SRC_BOUNDED_QUEUE_H_
+#define SRC_BOUNDED_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/// Bounded lock-free queue, multiple producers and consumers
+/**
+ * Array based queue where every cell carries a sequence number telling
+ * whether it is ready to be written or read in the current lap (D. Vyukov's
+ * bounded MPMC queue). push() and pop() never block and never allocate; the
+ * capacity is rounded up to a power of two.
+ *
+ * T must be default constructible and move assignable.
+ */
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity)
+      : mask_(roundCapacity(capacity) - 1),
+        cells_(new Cell[mask_ + 1]) {
+    for (size_t i = 0; i <= mask_; ++i)
+      cells_[i].sequence_.store(i, std::memory_order_relaxed);
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+
+  /// Approximate number of queued elements
+  size_t size() const {
+    size_t tail = dequeue_pos_.load(std::memory_order_acquire);
+    size_t head = enqueue_pos_.load(std::memory_order_acquire);
+    return head > tail ? head - tail : 0;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  /// @return false if the queue is full, `value` is left untouched
+  bool push(T&& value) {
+    Cell* cell;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence_.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value_ = std::move(value);
+    cell->sequence_.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @return false if the queue is empty
+  bool pop(T& value) {
+    Cell* cell;
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence_.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    value = std::move(cell->value_);
+    cell->value_ = T();
+    cell->sequence_.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence_;
+    T value_;
+  };
+
+  static size_t roundCapacity(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    return size;
+  }
+
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+
+  // producers and consumers write to separate cache lines
+  char pad0_[64];
+  std::atomic<size_t> enqueue_pos_{0};
+  char pad1_[64];
+  std::atomic<size_t> dequeue_pos_{0};
+};
+
+#endif  // SRC_BOUNDED_QUEUE_H_
@@ -17,6 +17,7 @@
 #include <cpqd/asr-client/buffer_audio_source.h>
 
 #include <atomic>
+#include <condition_variable>
 
 #include "src/ringbuffer.h"
 
@@ -30,6 +31,9 @@ class BufferAudioSource::Impl {
     std::atomic<bool> finished_{false};
 
     std::atomic<bool> to_read_{false};
+
+    // signaled when the buffer is read or finished
+    std::condition_variable room_;
 };
 
 BufferAudioSource::BufferAudioSource(AudioFormat fmt, size_t buffer_size) :
@@ -46,6 +50,7 @@ int BufferAudioSource::read(std::vector<char> &buffer) {
 
   int ret = impl_->ring_buffer_.ReadAll(buffer);
   impl_->to_read_ = false;
+  if (ret > 0) impl_->room_.notify_all();
 
   return ret;
 }
@@ -55,9 +60,10 @@ bool BufferAudioSource::write(std::vector<char> &buffer) {
   if (impl_->finished_)
     return false;
 
-  impl_->ring_buffer_.Write(buffer.data(), buffer.size());
+  unsigned int written =
+      impl_->ring_buffer_.Write(buffer.data(), buffer.size());
   impl_->to_read_ = true;
-  return true;
+  return written == buffer.size();
 }
 
 bool BufferAudioSource::write(char* buffer, size_t size) {
@@ -65,13 +71,45 @@ bool BufferAudioSource::write(char* buffer, size_t size) {
   if (impl_->finished_)
     return false;
 
-  impl_->ring_buffer_.Write(buffer, size);
+  unsigned int written = impl_->ring_buffer_.Write(buffer, size);
   impl_->to_read_ = true;
+  return written == size;
+}
+
+bool BufferAudioSource::write(const char* buffer, size_t size,
+                              std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  std::unique_lock<std::mutex> l(mtx_);
+  while (size > 0) {
+    if (impl_->finished_)
+      return false;
+
+    unsigned int written = impl_->ring_buffer_.Write(buffer, size);
+    if (written > 0) {
+      impl_->to_read_ = true;
+      buffer += written;
+      size -= written;
+      continue;
+    }
+
+    if (impl_->room_.wait_until(l, deadline) == std::cv_status::timeout &&
+        impl_->ring_buffer_.GetWriteAvail() == 0)
+      return false;
+  }
   return true;
 }
 
+size_t BufferAudioSource::writeAvailable() {
+  std::unique_lock<std::mutex> l(mtx_);
+  return impl_->ring_buffer_.GetWriteAvail();
+}
+
 void BufferAudioSource::close() {}
 
 void BufferAudioSource::finish() {
-  impl_->finished_ = true;
+  {
+    std::unique_lock<std::mutex> l(mtx_);
+    impl_->finished_ = true;
+  }
+  impl_->room_.notify_all();
 }
@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <cpqd/asr-client/callback_executor.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace {
+
+class InlineExecutor : public CallbackExecutor {
+ public:
+  void execute(std::function<void()> task) { task(); }
+};
+
+class ThreadExecutor : public CallbackExecutor {
+ public:
+  ThreadExecutor()
+      : state_(std::make_shared<State>()),
+        thread_(&ThreadExecutor::run, state_) {}
+
+  ~ThreadExecutor() {
+    {
+      std::unique_lock<std::mutex> lk(state_->lock_);
+      state_->stop_ = true;
+    }
+    state_->cv_.notify_one();
+    // Pending tasks are still run before the thread exits. When the last
+    // reference is dropped by one of the tasks, the thread finishes on its
+    // own, it keeps the queue alive.
+    if (thread_.get_id() == std::this_thread::get_id())
+      thread_.detach();
+    else
+      thread_.join();
+  }
+
+  void execute(std::function<void()> task) {
+    {
+      std::unique_lock<std::mutex> lk(state_->lock_);
+      state_->tasks_.push_back(std::move(task));
+    }
+    state_->cv_.notify_one();
+  }
+
+ private:
+  struct State {
+    std::mutex lock_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stop_ = false;
+  };
+
+  static void run(std::shared_ptr<State> state) {
+    std::unique_lock<std::mutex> lk(state->lock_);
+    while (true) {
+      state->cv_.wait(lk, [&state]() {
+        return state->stop_ || !state->tasks_.empty();
+      });
+      if (state->tasks_.empty()) return;
+
+      std::function<void()> task = std::move(state->tasks_.front());
+      state->tasks_.pop_front();
+      lk.unlock();
+      task();
+      task = nullptr;
+      lk.lock();
+    }
+  }
+
+  std::shared_ptr<State> state_;
+  std::thread thread_;
+};
+
+}  // namespace
+
+std::shared_ptr<CallbackExecutor> CallbackExecutor::inlineExecutor() {
+  return std::make_shared<InlineExecutor>();
+}
+
+std::shared_ptr<CallbackExecutor> CallbackExecutor::dedicatedThread() {
+  return std::make_shared<ThreadExecutor>();
+}
@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include "src/callback_strand.h"
+
+#include <utility>
+
+CallbackStrand::CallbackStrand(std::shared_ptr<CallbackExecutor> executor)
+    : executor_(executor ? std::move(executor)
+                         : CallbackExecutor::inlineExecutor()) {}
+
+CallbackStrand::~CallbackStrand() {
+  drain();
+}
+
+void CallbackStrand::post(std::function<void()> task) {
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    queue_.push_back(std::move(task));
+    if (queue_.size() > max_depth_) max_depth_ = queue_.size();
+    if (scheduled_) return;
+    scheduled_ = true;
+  }
+  executor_->execute(std::bind(&CallbackStrand::run, this));
+}
+
+void CallbackStrand::drain() {
+  std::unique_lock<std::mutex> lk(lock_);
+  if (running_thread_ == std::this_thread::get_id()) return;
+  idle_cv_.wait(lk, [this]() { return !scheduled_; });
+}
+
+void CallbackStrand::metrics(RecognizerMetrics& metrics) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  std::unique_lock<std::mutex> lk(lock_);
+  metrics.callback_queue_depth_ = queue_.size();
+  metrics.callback_queue_max_depth_ = max_depth_;
+  metrics.callbacks_ = executed_;
+  metrics.callback_errors_ = errors_;
+  metrics.callback_time_ = duration_cast<microseconds>(busy_time_);
+  metrics.callback_max_time_ = duration_cast<microseconds>(max_time_);
+}
+
+void CallbackStrand::run() {
+  std::unique_lock<std::mutex> lk(lock_);
+  running_thread_ = std::this_thread::get_id();
+
+  for (int i = 0; i < kBatchSize && !queue_.empty(); ++i) {
+    std::function<void()> task = std::move(queue_.front());
+    queue_.pop_front();
+    lk.unlock();
+
+    bool failed = false;
+    auto start = std::chrono::steady_clock::now();
+    try {
+      task();
+    } catch (...) {
+      // A failing listener must not stop the callbacks queued after it
+      failed = true;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    task = nullptr;
+
+    lk.lock();
+    ++executed_;
+    if (failed) ++errors_;
+    busy_time_ += elapsed;
+    if (elapsed > max_time_) max_time_ = elapsed;
+  }
+
+  running_thread_ = std::thread::id();
+  if (queue_.empty()) {
+    scheduled_ = false;
+    idle_cv_.notify_all();
+    return;
+  }
+
+  // Yield the executor, the rest of the queue runs on a new task
+  lk.unlock();
+  executor_->execute(std::bind(&CallbackStrand::run, this));
+}
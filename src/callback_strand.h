@@ -0,0 +1,81 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef SRC_CALLBACK_STRAND_H_
+#define SRC_CALLBACK_STRAND_H_
+
+#include <cpqd/asr-client/callback_executor.h>
+#include <cpqd/asr-client/recognizer_metrics.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/// Serializes the listener callbacks of one recognizer on an executor
+/**
+ * Tasks posted to the strand run one at a time and in the order they were
+ * posted, whatever the threading of the underlying executor. Only one drain
+ * task of the strand is queued on the executor at any time.
+ */
+class CallbackStrand {
+ public:
+  explicit CallbackStrand(std::shared_ptr<CallbackExecutor> executor);
+
+  /// Waits for the pending callbacks, see drain()
+  ~CallbackStrand();
+
+  CallbackStrand(const CallbackStrand&) = delete;
+  CallbackStrand& operator=(const CallbackStrand&) = delete;
+
+  void post(std::function<void()> task);
+
+  /// Block until every posted callback has run
+  /**
+   * Returns immediately when called from inside a callback of this strand.
+   */
+  void drain();
+
+  /// Fill the callback fields of a metrics snapshot
+  void metrics(RecognizerMetrics& metrics);
+
+ private:
+  // Tasks run per executor task, so a busy strand does not starve the other
+  // users of a shared executor
+  static const int kBatchSize = 16;
+
+  void run();
+
+  std::shared_ptr<CallbackExecutor> executor_;
+
+  std::mutex lock_;
+  std::condition_variable idle_cv_;
+  std::deque<std::function<void()>> queue_;
+  bool scheduled_ = false;
+  std::thread::id running_thread_;
+
+  size_t max_depth_ = 0;
+  uint64_t executed_ = 0;
+  uint64_t errors_ = 0;
+  std::chrono::steady_clock::duration busy_time_{0};
+  std::chrono::steady_clock::duration max_time_{0};
+};
+
+#endif  // SRC_CALLBACK_STRAND_H_
@@ -0,0 +1,82 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#include "src/chunk_sizer.h"
+
+#include <algorithm>
+
+const unsigned int ChunkSizer::kDefaultMinMilliseconds;
+const unsigned int ChunkSizer::kDefaultMaxMilliseconds;
+const int ChunkSizer::kBatchPollMilliseconds;
+
+void ChunkSizer::configure(AudioPacing pacing, unsigned int min_ms,
+                           unsigned int max_ms) {
+  pacing_ = pacing;
+  min_ms_ = min_ms;
+  max_ms_ = max_ms;
+}
+
+void ChunkSizer::setFormat(const AudioFormat& fmt) {
+  sample_bytes_ = std::max(1u, fmt.bits_per_sample_ / 8);
+  sample_rate_ = fmt.sample_rate_;
+}
+
+void ChunkSizer::observeRtt(std::chrono::microseconds rtt) {
+  int64_t smoothed = rtt_us_;
+  // 1/8 gain, as the TCP smoothed round trip time
+  rtt_us_ = smoothed == 0 ? rtt.count()
+                          : smoothed + (rtt.count() - smoothed) / 8;
+}
+
+size_t ChunkSizer::bytes(std::chrono::microseconds duration) const {
+  size_t samples =
+      static_cast<size_t>(duration.count()) * sample_rate_ / 1000000;
+  return std::max(sample_bytes_, align(samples * sample_bytes_));
+}
+
+size_t ChunkSizer::next(size_t backlog, bool last) const {
+  if (backlog == 0) return 0;
+
+  size_t min_bytes = bytes(std::chrono::milliseconds(min_ms_));
+  size_t max_bytes = bytes(std::chrono::milliseconds(max_ms_));
+
+  size_t target;
+  switch (pacing_) {
+    case AudioPacing::LIVE:
+      target = backlog > max_bytes ? max_bytes : min_bytes;
+      break;
+    case AudioPacing::BATCH:
+      target = max_bytes;
+      break;
+    default:
+      target = std::min(align(backlog), max_bytes);
+      target = std::max(target, bytes(rtt() / 4));
+      target = std::min(std::max(target, min_bytes), max_bytes);
+      break;
+  }
+
+  if (backlog >= target) return target;
+
+  // the end of the stream is sent as is, otherwise wait for a whole frame
+  return last ? backlog : 0;
+}
+
+std::chrono::milliseconds ChunkSizer::pollInterval() const {
+  if (pacing_ == AudioPacing::BATCH)
+    return std::chrono::milliseconds(kBatchPollMilliseconds);
+  return std::chrono::milliseconds(min_ms_);
+}
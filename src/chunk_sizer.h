@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#ifndef SRC_CHUNK_SIZER_H_
+#define SRC_CHUNK_SIZER_H_
+
+#include <cpqd/asr-client/audio_source.h>
+#include <cpqd/asr-client/speech_recog.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// Size of the audio messages sent to the server
+/**
+ * Audio read from the source is split into frames whose duration depends on
+ * the pacing mode, the backlog of audio read but not sent yet and the round
+ * trip time observed on the connection, within [min, max] milliseconds:
+ *
+ * - LIVE sends the shortest frames, switching to the longest ones only to
+ *   flush a backlog of more than a long frame;
+ * - BATCH always sends the longest frames;
+ * - AUTO sends the whole backlog at once, as long as it fits a frame, and no
+ *   frame shorter than a quarter of the round trip time, which would only
+ *   add messages: the server can't answer sooner than a round trip anyway.
+ *
+ * Every frame but the last one of the stream is aligned to sample
+ * boundaries.
+ */
+class ChunkSizer {
+ public:
+  static const unsigned int kDefaultMinMilliseconds = 20;
+  static const unsigned int kDefaultMaxMilliseconds = 1000;
+
+  ChunkSizer() = default;
+
+  /// Set the policy, min_ms must be positive and not above max_ms
+  void configure(AudioPacing pacing, unsigned int min_ms,
+                 unsigned int max_ms);
+
+  AudioPacing pacing() const { return pacing_; }
+
+  /// Set the format of the audio of the next recognition
+  void setFormat(const AudioFormat& fmt);
+
+  /// Feed a round trip time measured on the connection
+  void observeRtt(std::chrono::microseconds rtt);
+
+  std::chrono::microseconds rtt() const {
+    return std::chrono::microseconds(rtt_us_);
+  }
+
+  /// Size of the next frame to send
+  /**
+   * @param [in] backlog Bytes read from the audio source, not sent yet.
+   * @param [in] last Whether the audio source has ended.
+   * @return zero if more audio should be read before sending.
+   */
+  size_t next(size_t backlog, bool last) const;
+
+  /// How long to wait for more audio between reads of the source
+  std::chrono::milliseconds pollInterval() const;
+
+  /// Bytes of the given duration of audio, aligned to a sample boundary
+  size_t bytes(std::chrono::microseconds duration) const;
+
+  /// Size of the longest frame
+  size_t maxFrame() const { return bytes(std::chrono::milliseconds(max_ms_)); }
+
+ private:
+  // Poll period of the BATCH mode, short frames are never needed
+  static const int kBatchPollMilliseconds = 100;
+
+  size_t align(size_t bytes) const { return bytes - bytes % sample_bytes_; }
+
+  AudioPacing pacing_ = AudioPacing::AUTO;
+  unsigned int min_ms_ = kDefaultMinMilliseconds;
+  unsigned int max_ms_ = kDefaultMaxMilliseconds;
+
+  size_t sample_bytes_ = 2;
+  unsigned int sample_rate_ = 8000;
+
+  // smoothed, updated from the I/O thread and read by the audio thread
+  std::atomic<int64_t> rtt_us_{0};
+};
+
+#endif  // SRC_CHUNK_SIZER_H_
@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <cpqd/asr-client/completion_queue.h>
+
+#include <utility>
+
+bool CompletionQueue::waitAny(Event& event,
+                              std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lk(lock_);
+  if (!cv_.wait_for(lk, timeout, [this]() {
+        return !events_.empty() || shutdown_;
+      })) {
+    return false;
+  }
+  if (events_.empty()) return false;
+
+  event = std::move(events_.front());
+  events_.pop_front();
+  return true;
+}
+
+bool CompletionQueue::poll(Event& event) {
+  std::unique_lock<std::mutex> lk(lock_);
+  if (events_.empty()) return false;
+
+  event = std::move(events_.front());
+  events_.pop_front();
+  return true;
+}
+
+void CompletionQueue::post(Event event) {
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    events_.push_back(std::move(event));
+  }
+  cv_.notify_one();
+}
+
+void CompletionQueue::shutdown() {
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    shutdown_ = true;
+  }
+  cv_.notify_all();
+}
+
+size_t CompletionQueue::size() {
+  std::unique_lock<std::mutex> lk(lock_);
+  return events_.size();
+}
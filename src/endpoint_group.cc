@@ -0,0 +1,425 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#include <cpqd/asr-client/endpoint_group.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// FNV-1a, the same channel maps to the same server in every process
+uint64_t hash(const std::string& text, uint64_t seed = 14695981039346656037u) {
+  uint64_t h = seed;
+  for (unsigned char c : text) {
+    h ^= c;
+    h *= 1099511628211u;
+  }
+  return h;
+}
+
+// splitmix64 finalizer, spreads the combined hash over the whole range
+uint64_t mix(uint64_t h) {
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9u;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebu;
+  return h ^ (h >> 31);
+}
+
+// Weight of a latency in the usual latency of a server, small enough for a
+// burst of slow results to stand out
+const double kLatencyWeight = 0.1;
+
+}  // namespace
+
+const size_t EndpointGroup::kNoEndpoint;
+const size_t EndpointGroup::kMinLatencySamples;
+const size_t EndpointGroup::kLatencySamples;
+
+EndpointGroup::EndpointGroup(const std::vector<std::string>& urls)
+    : EndpointGroup(urls, Options()) {}
+
+EndpointGroup::EndpointGroup(const std::vector<std::string>& urls,
+                             const Options& options)
+    : options_(options), random_(std::random_device()()) {
+  if (urls.empty()) throw std::invalid_argument("Empty endpoint list");
+  if (options_.failure_threshold_ == 0)
+    throw std::invalid_argument("Failure threshold must be positive");
+  if (options_.setup_time_weight_ <= 0 || options_.setup_time_weight_ > 1)
+    throw std::invalid_argument("Setup time weight must be in (0, 1]");
+  if (options_.hedge_percentile_ < 0 || options_.hedge_percentile_ >= 100)
+    throw std::invalid_argument("Hedge percentile must be in [0, 100)");
+  if (options_.concurrency_limit_ > 0 &&
+      (options_.min_concurrency_ == 0 ||
+       options_.min_concurrency_ > options_.max_concurrency_))
+    throw std::invalid_argument("Invalid concurrency bounds");
+  if (options_.backoff_ratio_ <= 0 || options_.backoff_ratio_ >= 1)
+    throw std::invalid_argument("Backoff ratio must be in (0, 1)");
+  if (options_.latency_tolerance_ < 1)
+    throw std::invalid_argument("Latency tolerance must be at least 1");
+  for (const auto& weight : options_.tenant_weights_)
+    if (weight.second <= 0)
+      throw std::invalid_argument("Tenant weight must be positive");
+
+  for (const std::string& url : urls) {
+    bool found_scheme = (url.find("ws://") == 0) || (url.find("wss://") == 0);
+    if (!found_scheme) throw std::invalid_argument("invalid url " + url);
+
+    Endpoint endpoint;
+    endpoint.url = url;
+    endpoint.key = hash(url);
+    endpoint.limit = std::min(
+        std::max<double>(options_.concurrency_limit_,
+                         options_.min_concurrency_),
+        static_cast<double>(options_.max_concurrency_));
+    endpoints_.push_back(endpoint);
+  }
+}
+
+size_t EndpointGroup::acquire(const std::string& channel, size_t avoid) {
+  std::unique_lock<std::mutex> lk(lock_);
+  Clock::time_point now = Clock::now();
+
+  std::vector<size_t> candidates;
+  for (size_t i = 0; i < endpoints_.size(); ++i) {
+    if (i != avoid && selectable(endpoints_[i], now)) candidates.push_back(i);
+  }
+  if (candidates.empty() && avoid < endpoints_.size() &&
+      selectable(endpoints_[avoid], now)) {
+    candidates.push_back(avoid);
+  }
+
+  size_t chosen;
+  if (candidates.empty()) {
+    // every server is out, the one due first is probed early
+    chosen = 0;
+    for (size_t i = 1; i < endpoints_.size(); ++i) {
+      if (endpoints_[i].retry_at < endpoints_[chosen].retry_at) chosen = i;
+    }
+  } else {
+    chosen = pick(candidates, channel);
+  }
+
+  Endpoint& endpoint = endpoints_[chosen];
+  // the first connection after the open time is the probe
+  if (endpoint.open) endpoint.probing = true;
+  ++endpoint.outstanding;
+  ++endpoint.selections;
+  return chosen;
+}
+
+void EndpointGroup::release(size_t endpoint) {
+  std::unique_lock<std::mutex> lk(lock_);
+  Endpoint& e = endpoints_.at(endpoint);
+  if (e.outstanding > 0) --e.outstanding;
+}
+
+void EndpointGroup::succeeded(size_t endpoint,
+                              std::chrono::microseconds setup_time) {
+  std::unique_lock<std::mutex> lk(lock_);
+  Endpoint& e = endpoints_.at(endpoint);
+
+  double sample = static_cast<double>(setup_time.count());
+  bool slow =
+      options_.slow_setup_.count() > 0 && setup_time > options_.slow_setup_;
+  // a setup much slower than usual is overload as much as a late result
+  if (options_.concurrency_limit_ > 0 &&
+      (slow || (e.measured && e.setup_us > 0 &&
+                sample > options_.latency_tolerance_ * e.setup_us))) {
+    decrease(e);
+  }
+
+  if (e.measured) {
+    e.setup_us += options_.setup_time_weight_ * (sample - e.setup_us);
+  } else {
+    e.setup_us = sample;
+    e.measured = true;
+  }
+
+  if (slow) {
+    failure(e, Clock::now());
+    return;
+  }
+  e.failures = 0;
+  e.open = false;
+  e.probing = false;
+}
+
+void EndpointGroup::failed(size_t endpoint) {
+  std::unique_lock<std::mutex> lk(lock_);
+  failure(endpoints_.at(endpoint), Clock::now());
+}
+
+bool EndpointGroup::admit(size_t endpoint) {
+  return admit(endpoint, Admission());
+}
+
+bool EndpointGroup::admit(size_t endpoint, const Admission& admission) {
+  std::unique_lock<std::mutex> lk(lock_);
+  Endpoint& e = endpoints_.at(endpoint);
+  if (options_.concurrency_limit_ == 0) {
+    ++e.in_flight;
+    return true;
+  }
+
+  // no cutting in line, a free slot goes to those already waiting
+  if (e.waiters.empty() && hasSlot(e)) {
+    ++e.in_flight;
+    return true;
+  }
+  if (!admission.wait_ || options_.admission_wait_.count() <= 0) {
+    ++e.rejections;
+    return false;
+  }
+
+  // weighted fair queuing: each recognition costs one slot, divided by the
+  // weight of its tenant
+  size_t priority = static_cast<size_t>(admission.priority_);
+  FairQueue& queue = e.classes[priority];
+  auto configured = options_.tenant_weights_.find(admission.tenant_);
+  double weight =
+      configured != options_.tenant_weights_.end() ? configured->second : 1;
+
+  double& last_finish = queue.finish[admission.tenant_];
+  Waiter waiter;
+  waiter.priority = priority;
+  waiter.finish = std::max(queue.virtual_time, last_finish) + 1 / weight;
+  waiter.seq = admission_seq_++;
+  waiter.granted = false;
+  last_finish = waiter.finish;
+
+  e.waiters.push_back(&waiter);
+  admission_cv_.wait_for(lk, options_.admission_wait_,
+                         [&waiter]() { return waiter.granted; });
+  if (waiter.granted) return true;
+
+  e.waiters.remove(&waiter);
+  left(e, priority);
+  ++e.rejections;
+  return false;
+}
+
+void EndpointGroup::complete(size_t endpoint,
+                             std::chrono::microseconds latency,
+                             bool overload) {
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    Endpoint& e = endpoints_.at(endpoint);
+    if (e.in_flight > 0) --e.in_flight;
+
+    if (options_.concurrency_limit_ > 0) {
+      double sample = static_cast<double>(latency.count());
+      if (overload ||
+          (sample > 0 && e.latency_us > 0 &&
+           sample > options_.latency_tolerance_ * e.latency_us)) {
+        decrease(e);
+      } else if (sample > 0) {
+        // one more slot for every limit recognitions on time
+        e.limit = std::min(e.limit + 1 / e.limit,
+                           static_cast<double>(options_.max_concurrency_));
+      }
+      if (sample > 0) {
+        e.latency_us = e.latency_us > 0
+                           ? e.latency_us + kLatencyWeight *
+                                                (sample - e.latency_us)
+                           : sample;
+      }
+      dispatch(e);
+    }
+  }
+  admission_cv_.notify_all();
+}
+
+bool EndpointGroup::hedgeDelay(std::chrono::milliseconds& delay) {
+  if (options_.hedge_percentile_ <= 0) return false;
+
+  std::unique_lock<std::mutex> lk(lock_);
+  ++hedge_eligible_;
+  if (latencies_.size() < kMinLatencySamples) return false;
+
+  std::vector<int64_t> sorted(latencies_);
+  size_t rank = static_cast<size_t>(options_.hedge_percentile_ / 100 *
+                                    sorted.size());
+  std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+  delay = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::microseconds(sorted[rank]));
+  return true;
+}
+
+bool EndpointGroup::takeHedge() {
+  std::unique_lock<std::mutex> lk(lock_);
+  if (hedges_ >= options_.hedge_budget_ * hedge_eligible_) return false;
+  ++hedges_;
+  return true;
+}
+
+void EndpointGroup::recordLatency(std::chrono::microseconds latency) {
+  std::unique_lock<std::mutex> lk(lock_);
+  if (latencies_.size() < kLatencySamples) {
+    latencies_.push_back(latency.count());
+  } else {
+    latencies_[next_latency_] = latency.count();
+    next_latency_ = (next_latency_ + 1) % kLatencySamples;
+  }
+}
+
+const std::string& EndpointGroup::url(size_t endpoint) const {
+  return endpoints_.at(endpoint).url;
+}
+
+std::vector<EndpointGroup::Stats> EndpointGroup::stats() {
+  std::unique_lock<std::mutex> lk(lock_);
+  std::vector<Stats> ret;
+  for (const Endpoint& e : endpoints_) {
+    Stats stats;
+    stats.url_ = e.url;
+    stats.outstanding_ = e.outstanding;
+    stats.setup_time_ =
+        std::chrono::microseconds(static_cast<int64_t>(e.setup_us));
+    stats.failures_ = e.failures;
+    stats.available_ = !e.open;
+    stats.ejections_ = e.ejections;
+    stats.selections_ = e.selections;
+    stats.in_flight_ = e.in_flight;
+    stats.concurrency_limit_ =
+        options_.concurrency_limit_ > 0 ? static_cast<unsigned int>(e.limit)
+                                        : 0;
+    stats.rejections_ = e.rejections;
+    stats.queued_ = e.waiters.size();
+    ret.push_back(stats);
+  }
+  return ret;
+}
+
+bool EndpointGroup::selectable(const Endpoint& endpoint,
+                               Clock::time_point now) const {
+  if (!endpoint.open) return true;
+  // one probe at a time
+  return !endpoint.probing && now >= endpoint.retry_at;
+}
+
+size_t EndpointGroup::pick(const std::vector<size_t>& candidates,
+                           const std::string& channel) {
+  // candidates in round robin order, ties go to the next server in turn
+  size_t first = 0;
+  while (first < candidates.size() && candidates[first] < next_) ++first;
+  if (first == candidates.size()) first = 0;
+
+  size_t chosen = candidates[first];
+  switch (options_.policy_) {
+    case EndpointPolicy::ROUND_ROBIN:
+      break;
+
+    case EndpointPolicy::LEAST_OUTSTANDING:
+      for (size_t n = 1; n < candidates.size(); ++n) {
+        size_t i = candidates[(first + n) % candidates.size()];
+        if (endpoints_[i].outstanding < endpoints_[chosen].outstanding)
+          chosen = i;
+      }
+      break;
+
+    case EndpointPolicy::LATENCY_WEIGHTED: {
+      // servers never measured are tried first
+      for (size_t n = 0; n < candidates.size(); ++n) {
+        size_t i = candidates[(first + n) % candidates.size()];
+        if (!endpoints_[i].measured) {
+          chosen = i;
+          break;
+        }
+      }
+      if (!endpoints_[chosen].measured) break;
+
+      std::vector<double> weights;
+      for (size_t i : candidates) {
+        // a setup under 1 us is as fast as it gets
+        double setup = endpoints_[i].setup_us < 1 ? 1 : endpoints_[i].setup_us;
+        weights.push_back(1 / setup);
+      }
+      std::discrete_distribution<size_t> distribution(weights.begin(),
+                                                      weights.end());
+      chosen = candidates[distribution(random_)];
+      break;
+    }
+
+    case EndpointPolicy::CHANNEL_AFFINITY: {
+      if (channel.empty()) break;
+      // rendezvous hashing: a server taken out only moves its own channels
+      uint64_t channel_key = hash(channel);
+      uint64_t best = 0;
+      for (size_t i : candidates) {
+        uint64_t score = mix(channel_key ^ endpoints_[i].key);
+        if (i == candidates.front() || score > best) {
+          best = score;
+          chosen = i;
+        }
+      }
+      break;
+    }
+  }
+
+  next_ = (chosen + 1) % endpoints_.size();
+  return chosen;
+}
+
+bool EndpointGroup::hasSlot(const Endpoint& endpoint) const {
+  return endpoint.in_flight < static_cast<unsigned int>(endpoint.limit);
+}
+
+void EndpointGroup::dispatch(Endpoint& endpoint) {
+  while (hasSlot(endpoint) && !endpoint.waiters.empty()) {
+    // strict priority between classes, earliest finish tag within one
+    auto best = endpoint.waiters.begin();
+    for (auto it = std::next(best); it != endpoint.waiters.end(); ++it) {
+      const Waiter& w = **it;
+      const Waiter& b = **best;
+      if (w.priority != b.priority ? w.priority < b.priority
+          : w.finish != b.finish   ? w.finish < b.finish
+                                   : w.seq < b.seq)
+        best = it;
+    }
+
+    Waiter& granted = **best;
+    endpoint.waiters.erase(best);
+    granted.granted = true;
+    ++endpoint.in_flight;
+
+    endpoint.classes[granted.priority].virtual_time = granted.finish;
+    left(endpoint, granted.priority);
+  }
+}
+
+void EndpointGroup::left(Endpoint& endpoint, size_t priority) {
+  // the tags only order the recognitions waiting together
+  for (Waiter* w : endpoint.waiters)
+    if (w->priority == priority) return;
+  endpoint.classes[priority].finish.clear();
+}
+
+void EndpointGroup::decrease(Endpoint& endpoint) {
+  endpoint.limit = std::max(endpoint.limit * options_.backoff_ratio_,
+                            static_cast<double>(options_.min_concurrency_));
+}
+
+void EndpointGroup::failure(Endpoint& endpoint, Clock::time_point now) {
+  ++endpoint.failures;
+  // a failed probe takes the server out again right away
+  if (endpoint.probing || endpoint.failures >= options_.failure_threshold_) {
+    if (!endpoint.open || endpoint.probing) ++endpoint.ejections;
+    endpoint.open = true;
+    endpoint.probing = false;
+    endpoint.retry_at = now + options_.open_time_;
+  }
+}
@@ -45,8 +45,10 @@ LanguageModelList::Builder& LanguageModelList::Builder::addInlineGrammar(
   return *this;
 }
 
-std::string LanguageModelList::getUri() { return properties_.uri_; }
+const std::string& LanguageModelList::getUri() const {
+  return properties_.uri_;
+}
 
-std::string LanguageModelList::getGrammarBody() {
+const std::string& LanguageModelList::getGrammarBody() const {
   return properties_.grammar_body_;
 }
@@ -0,0 +1,139 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#include <cpqd/asr-client/language_model_registry.h>
+
+#include <cpqd/asr-client/recognition_exception.h>
+
+#include <sys/stat.h>
+
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+bool modificationTime(const std::string& path, std::time_t& mtime) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) return false;
+  mtime = st.st_mtime;
+  return true;
+}
+
+std::shared_ptr<const LanguageModelList> loadGrammar(const std::string& path) {
+  std::ifstream ifs(path, std::ifstream::in | std::ifstream::binary);
+  if (!ifs.is_open()) return nullptr;
+
+  std::stringstream body;
+  body << ifs.rdbuf();
+  if (ifs.bad()) return nullptr;
+  return LanguageModelList::Builder().addInlineGrammar(body.str()).build();
+}
+
+}  // namespace
+
+LanguageModelRegistry& LanguageModelRegistry::global() {
+  static LanguageModelRegistry registry;
+  return registry;
+}
+
+void LanguageModelRegistry::addFromURI(const std::string& name,
+                                       const std::string& uri) {
+  Entry entry;
+  entry.lm_ = LanguageModelList::Builder().addFromURI(uri).build();
+
+  std::unique_lock<std::mutex> lk(lock_);
+  models_[name] = std::move(entry);
+}
+
+void LanguageModelRegistry::addInlineGrammar(const std::string& name,
+                                             const std::string& body) {
+  Entry entry;
+  entry.lm_ = LanguageModelList::Builder().addInlineGrammar(body).build();
+
+  std::unique_lock<std::mutex> lk(lock_);
+  models_[name] = std::move(entry);
+}
+
+void LanguageModelRegistry::addGrammarFile(const std::string& name,
+                                           const std::string& path) {
+  Entry entry;
+  entry.path_ = path;
+  entry.checked_ = Clock::now();
+  if (!modificationTime(path, entry.mtime_) ||
+      !(entry.lm_ = loadGrammar(path))) {
+    throw RecognitionException(RecognitionError::Code::FAILURE,
+                               "Failure reading grammar file " + path);
+  }
+
+  std::unique_lock<std::mutex> lk(lock_);
+  models_[name] = std::move(entry);
+}
+
+std::shared_ptr<const LanguageModelList> LanguageModelRegistry::get(
+    const std::string& name) {
+  std::string path;
+  std::time_t known;
+  std::shared_ptr<const LanguageModelList> current;
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    auto it = models_.find(name);
+    if (it == models_.end()) {
+      throw RecognitionException(RecognitionError::Code::FAILURE,
+                                 "Unknown language model " + name);
+    }
+
+    Entry& entry = it->second;
+    Clock::time_point now = Clock::now();
+    if (entry.path_.empty() || now - entry.checked_ < reload_check_interval_)
+      return entry.lm_;
+
+    // the other callers keep the current model while this one checks
+    entry.checked_ = now;
+    path = entry.path_;
+    known = entry.mtime_;
+    current = entry.lm_;
+  }
+
+  // the file is read without the lock, get() of other models goes on
+  std::time_t mtime;
+  if (!modificationTime(path, mtime) || mtime == known) return current;
+  std::shared_ptr<const LanguageModelList> lm = loadGrammar(path);
+  if (!lm) return current;
+
+  std::unique_lock<std::mutex> lk(lock_);
+  auto it = models_.find(name);
+  if (it == models_.end()) return lm;
+  Entry& entry = it->second;
+  // unless the model was replaced meanwhile
+  if (entry.lm_ == current) {
+    entry.lm_ = lm;
+    entry.mtime_ = mtime;
+  }
+  return entry.lm_;
+}
+
+void LanguageModelRegistry::remove(const std::string& name) {
+  std::unique_lock<std::mutex> lk(lock_);
+  models_.erase(name);
+}
+
+void LanguageModelRegistry::setReloadCheckInterval(
+    std::chrono::milliseconds interval) {
+  std::unique_lock<std::mutex> lk(lock_);
+  reload_check_interval_ = interval;
+}
@@ -0,0 +1,75 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include "src/outbound_scheduler.h"
+
+#include <utility>
+
+const size_t OutboundScheduler::kDefaultAudioHighWater;
+const int OutboundScheduler::kPollMilliseconds;
+
+OutboundScheduler::OutboundScheduler(SendFunction send,
+                                     BufferedFunction buffered)
+    : send_(std::move(send)), buffered_(std::move(buffered)) {}
+
+void OutboundScheduler::sendControl(const std::string& message) {
+  ++control_messages_;
+  send_(message);
+}
+
+bool OutboundScheduler::sendAudio(const std::string& message) {
+  std::unique_lock<std::mutex> lk(lock_);
+  size_t buffered = buffered_();
+  if (buffered > max_buffered_) max_buffered_ = buffered;
+
+  if (!discard_audio_ && buffered >= audio_high_water_) {
+    ++stalls_;
+    auto start = std::chrono::steady_clock::now();
+    while (!discard_audio_ && buffered_() >= audio_high_water_) {
+      cv_.wait_for(lk, std::chrono::milliseconds(kPollMilliseconds));
+    }
+    stall_time_us_ += std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+  if (discard_audio_) return false;
+
+  // Sent with the lock held: once discardAudio() returns, no audio can be
+  // written after the control message that follows it
+  ++audio_messages_;
+  send_(message);
+  return true;
+}
+
+void OutboundScheduler::discardAudio() {
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    discard_audio_ = true;
+  }
+  cv_.notify_all();
+}
+
+void OutboundScheduler::resumeAudio() {
+  std::unique_lock<std::mutex> lk(lock_);
+  discard_audio_ = false;
+}
+
+void OutboundScheduler::metrics(RecognizerMetrics& metrics) {
+  metrics.control_messages_ = control_messages_;
+  metrics.audio_messages_ = audio_messages_;
+  metrics.audio_stalls_ = stalls_;
+  metrics.audio_stall_time_ = stallTime();
+  metrics.send_max_buffered_ = max_buffered_;
+}
@@ -0,0 +1,100 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef SRC_OUTBOUND_SCHEDULER_H_
+#define SRC_OUTBOUND_SCHEDULER_H_
+
+#include <cpqd/asr-client/recognizer_metrics.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+/// Outbound message scheduling of a connection, control before audio
+/**
+ * Every message ends up in the send queue of the WebSocket connection, which
+ * is first in, first out. Control messages (session setup, cancel, ...) are
+ * written to it right away, from the calling thread. Audio is only written
+ * while the bytes still buffered by the connection are below the audio high
+ * water mark, so a control message never waits behind more than that amount
+ * of audio, however fast the audio source is read.
+ *
+ * Holding the audio thread back is also the send side flow control: while it
+ * waits the audio source is not read, so a slow link makes the source fill
+ * up instead of the connection send queue growing without limit.
+ */
+class OutboundScheduler {
+ public:
+  typedef std::function<void(const std::string&)> SendFunction;
+  typedef std::function<size_t()> BufferedFunction;
+
+  static const size_t kDefaultAudioHighWater = 64 * 1024;
+
+  /**
+   * @param [in] send Writes a message to the connection.
+   * @param [in] buffered Bytes waiting in the send queue of the connection.
+   */
+  OutboundScheduler(SendFunction send, BufferedFunction buffered);
+
+  void setAudioHighWater(size_t bytes) { audio_high_water_ = bytes; }
+
+  /// Send a control message, ahead of the audio not yet written
+  void sendControl(const std::string& message);
+
+  /// Send an audio message, waiting for room in the connection send queue
+  /**
+   * @return false if audio was discarded meanwhile, the message is dropped.
+   */
+  bool sendAudio(const std::string& message);
+
+  /// Drop audio until resumeAudio(), waking up a blocked sendAudio()
+  void discardAudio();
+
+  /// Accept audio again, at the start of a recognition
+  void resumeAudio();
+
+  /// Time audio sends spent waiting for the send queue to drain
+  std::chrono::microseconds stallTime() const {
+    return std::chrono::microseconds(stall_time_us_);
+  }
+
+  /// Fill the outbound fields of a metrics snapshot
+  void metrics(RecognizerMetrics& metrics);
+
+ private:
+  // Polling period of the connection send queue while it is above the mark
+  static const int kPollMilliseconds = 2;
+
+  SendFunction send_;
+  BufferedFunction buffered_;
+  std::atomic<size_t> audio_high_water_{kDefaultAudioHighWater};
+
+  std::mutex lock_;
+  std::condition_variable cv_;
+  bool discard_audio_ = false;
+
+  std::atomic<uint64_t> control_messages_{0};
+  std::atomic<uint64_t> audio_messages_{0};
+  std::atomic<uint64_t> stalls_{0};
+  std::atomic<int64_t> stall_time_us_{0};
+  std::atomic<size_t> max_buffered_{0};
+};
+
+#endif  // SRC_OUTBOUND_SCHEDULER_H_
@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include "src/partial_coalescer.h"
+
+#include <algorithm>
+#include <utility>
+
+void PartialCoalescer::configure(std::chrono::milliseconds interval,
+                                 size_t min_text_delta) {
+  std::unique_lock<std::mutex> lk(lock_);
+  interval_ = interval;
+  min_text_delta_ = min_text_delta;
+}
+
+bool PartialCoalescer::offer(Pending partial, Clock::time_point now,
+                             std::chrono::milliseconds& wait) {
+  using std::chrono::duration_cast;
+  using std::chrono::milliseconds;
+
+  std::unique_lock<std::mutex> lk(lock_);
+  wait = milliseconds(0);
+  ++received_;
+  if (has_pending_) ++skipped_;
+  pending_ = std::move(partial);
+  has_pending_ = true;
+
+  if (!delivered_ || now - last_delivery_ >= interval_) return !timer_armed_;
+  if (timer_armed_) return false;
+
+  timer_armed_ = true;
+  wait = duration_cast<milliseconds>(last_delivery_ + interval_ - now);
+  if (wait.count() <= 0) wait = milliseconds(1);
+  return false;
+}
+
+bool PartialCoalescer::onTimer(Clock::time_point now) {
+  std::unique_lock<std::mutex> lk(lock_);
+  timer_armed_ = false;
+  return has_pending_ && (!delivered_ || now - last_delivery_ >= interval_);
+}
+
+bool PartialCoalescer::take(Clock::time_point now, Pending& partial) {
+  std::unique_lock<std::mutex> lk(lock_);
+  if (!has_pending_) return false;
+  partial = std::move(pending_);
+  pending_ = Pending();
+  has_pending_ = false;
+  delivered_ = true;
+  last_delivery_ = now;
+  return true;
+}
+
+bool PartialCoalescer::accept(PartialRecognition& partial) {
+  std::unique_lock<std::mutex> lk(lock_);
+  if (partial.speech_segment_index_ != last_segment_) {
+    last_segment_ = partial.speech_segment_index_;
+    last_text_.clear();
+  }
+
+  if (min_text_delta_ > 0 &&
+      textDelta(last_text_, partial.text_) < min_text_delta_) {
+    ++skipped_;
+    return false;
+  }
+
+  partial.stable_prefix_length_ = commonPrefix(last_text_, partial.text_);
+  partial.changed_suffix_.assign(partial.text_,
+                                 partial.stable_prefix_length_,
+                                 std::string::npos);
+  last_text_ = partial.text_;
+  return true;
+}
+
+void PartialCoalescer::reset() {
+  std::unique_lock<std::mutex> lk(lock_);
+  if (has_pending_) ++skipped_;
+  has_pending_ = false;
+  pending_ = Pending();
+  delivered_ = false;
+  last_segment_ = -1;
+  last_text_.clear();
+}
+
+void PartialCoalescer::metrics(RecognizerMetrics& metrics) {
+  std::unique_lock<std::mutex> lk(lock_);
+  metrics.partials_received_ = received_;
+  metrics.partials_skipped_ = skipped_;
+}
+
+size_t PartialCoalescer::commonPrefix(const std::string& a,
+                                      const std::string& b) {
+  size_t size = std::min(a.size(), b.size());
+  size_t prefix = 0;
+  while (prefix < size && a[prefix] == b[prefix]) ++prefix;
+
+  // back to the first byte of the code point the texts differ in
+  const std::string& longest = a.size() > b.size() ? a : b;
+  while (prefix > 0 && prefix < longest.size() &&
+         (static_cast<unsigned char>(longest[prefix]) & 0xC0) == 0x80)
+    --prefix;
+  return prefix;
+}
+
+size_t PartialCoalescer::textDelta(const std::string& a,
+                                   const std::string& b) {
+  size_t prefix = commonPrefix(a, b);
+  const std::string& longest = a.size() > b.size() ? a : b;
+
+  size_t delta = 0;
+  for (size_t i = prefix; i < longest.size(); ++i) {
+    if ((static_cast<unsigned char>(longest[i]) & 0xC0) != 0x80) ++delta;
+  }
+  return delta;
+}
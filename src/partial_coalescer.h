@@ -0,0 +1,133 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef SRC_PARTIAL_COALESCER_H_
+#define SRC_PARTIAL_COALESCER_H_
+
+#include <cpqd/asr-client/recognizer_metrics.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "src/asr_result_decoder.h"
+
+/// Rate limiting of partial results, the latest partial wins
+/**
+ * Partial result bodies are held here undecoded. A held partial is replaced
+ * by every newer one, and is delivered once the minimum interval since the
+ * previous delivery has elapsed. Partials whose text differs too little from
+ * the last delivered one are dropped at delivery time, so at most one body
+ * per interval is decoded.
+ *
+ * The text of the last delivered partial is also the base of the
+ * stable prefix / changed suffix delta of the next one.
+ */
+class PartialCoalescer {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Pending {
+    std::shared_ptr<const std::string> body_;
+    ASRResultDecoder::Routing routing_;
+  };
+
+  PartialCoalescer() = default;
+
+  /// Set the policy, zero disables the corresponding limit
+  void configure(std::chrono::milliseconds interval, size_t min_text_delta);
+
+  /// Whether partial results are coalesced at all
+  bool enabled() const {
+    return interval_.count() > 0 || min_text_delta_ > 0;
+  }
+
+  /// Hold a new partial result, replacing the one pending
+  /**
+   * @param [out] wait Delay of the flush timer to arm, zero if the partial
+   *   can be delivered now or a timer is already armed.
+   * @return true if take() should be called right away.
+   */
+  bool offer(Pending partial, Clock::time_point now,
+             std::chrono::milliseconds& wait);
+
+  /// Called when the flush timer expires
+  /**
+   * @return true if the pending partial is due.
+   */
+  bool onTimer(Clock::time_point now);
+
+  /// Take the pending partial for delivery
+  /**
+   * @return false if nothing is pending.
+   */
+  bool take(Clock::time_point now, Pending& partial);
+
+  /// Filter a decoded partial and fill its delta to the previous one
+  /**
+   * Every partial delivered, coalesced or not, goes through this method.
+   *
+   * @return false if the text differs from the previous partial of the
+   *   segment by less than the minimum text delta; the partial must then be
+   *   dropped.
+   */
+  bool accept(PartialRecognition& partial);
+
+  /// Whether accept() is needed on raw partials
+  bool filtersText() const { return min_text_delta_ > 0; }
+
+  /// Drop the pending partial and the delta base
+  /**
+   * Called on final results and new recognitions.
+   */
+  void reset();
+
+  /// Fill the partial result fields of a metrics snapshot
+  void metrics(RecognizerMetrics& metrics);
+
+  /// Length in bytes of the common prefix of two UTF-8 texts
+  /**
+   * Cut at a code point boundary.
+   */
+  static size_t commonPrefix(const std::string& a, const std::string& b);
+
+  /// Code points that differ between two UTF-8 texts
+  /**
+   * Counted from the end of their common prefix to the end of the longest
+   * text.
+   */
+  static size_t textDelta(const std::string& a, const std::string& b);
+
+ private:
+  std::chrono::milliseconds interval_{0};
+  size_t min_text_delta_ = 0;
+
+  std::mutex lock_;
+  bool has_pending_ = false;
+  Pending pending_;
+  bool timer_armed_ = false;
+  bool delivered_ = false;
+  Clock::time_point last_delivery_;
+  int last_segment_ = -1;
+  std::string last_text_;
+
+  uint64_t received_ = 0;
+  uint64_t skipped_ = 0;
+};
+
+#endif  // SRC_PARTIAL_COALESCER_H_
@@ -15,6 +15,7 @@
  *****************************************************************************/
 
 #include "src/process_msg.h"
+#include <algorithm>
 #include <mutex>
 
 #include <cpqd/asr-client/recognition_exception.h>
@@ -57,15 +58,15 @@ bool ASRProcessResponse::handle(SpeechRecognizer::Impl &impl,
   std::string status = getString(ResponseHeader::SessionStatus);
   std::string value = response.get_header(status);
 
-  if (status == getString(SessionStatus::Idle))
+  if (value == getString(SessionStatus::Idle))
     impl.session_status_ = SpeechRecognizer::Impl::SessionStatus::kIdle;
-  else if (status == getString(SessionStatus::Listening)) {
+  else if (value == getString(SessionStatus::Listening)) {
     impl.session_status_ = SpeechRecognizer::Impl::SessionStatus::kListening;
     // invoking callback
-    for (std::unique_ptr<RecognitionListener> &listener : impl.listener_) {
-      listener->onListening();
-    }
-  } else if (status == getString(SessionStatus::Recognizing))
+    impl.notifyListeners([](RecognitionListener &listener) {
+      listener.onListening();
+    });
+  } else if (value == getString(SessionStatus::Recognizing))
     impl.session_status_ = SpeechRecognizer::Impl::SessionStatus::kRecognizing;
 
   std::string method = getString(ResponseHeader::Method);
@@ -79,6 +80,10 @@ bool ASRProcessResponse::handle(SpeechRecognizer::Impl &impl,
     return startRecog(impl, response);
   } else if (value == getMethodString(Method::CancelRecognition)) {
     return cancelRecog(impl, response);
+  } else if (value == getMethodString(Method::ReleaseSession)) {
+    return releaseSession(impl, response);
+  } else if (value == getMethodString(Method::StartInputTimers)) {
+    return startInputTimers(impl, response);
   }
 
   return true;
@@ -93,9 +98,13 @@ bool ASRProcessResponse::createSession(SpeechRecognizer::Impl &impl,
     generateError(impl, response);
     return false;
   }
+  ++impl.sessions_;
 
+  // A new session has the server defaults, the whole config is sent
   ASRSendMessage send_msg_;
-  if (!impl.config_) {
+  impl.session_params_.reset();
+  impl.session_params_.prepare(*impl.recog_params_);
+  if (impl.session_params_.pending().empty()) {
     send_msg_.startRecognition(impl);
     return true;
   }
@@ -113,6 +122,7 @@ bool ASRProcessResponse::setParameters(SpeechRecognizer::Impl &impl,
     generateError(impl, response);
     return false;
   }
+  impl.session_params_.acknowledge();
 
   ASRSendMessage send_msg_;
   send_msg_.startRecognition(impl);
@@ -130,18 +140,19 @@ bool ASRProcessResponse::startRecog(SpeechRecognizer::Impl &impl,
     return false;
   }
 
-  if (impl.audio_src_ == nullptr) return false;
-//  impl.terminateSendMessageThread(); // Terminate any send message processes
-  impl.sendAudioMessage_thread_ =
-      std::thread(
-        &ASRProcessResponse::sendAudioMessage,
-        this, std::ref(impl)
-        );
+  impl.chunks_.observeRtt(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - impl.start_sent_));
+  impl.recognitionStarted();
   return true;
 }
 
 bool ASRProcessResponse::cancelRecog(SpeechRecognizer::Impl &impl,
                                      ASRMessageResponse &response) {
+  // the slower side of a hedged recognition, whose results were delivered
+  // by the other side
+  if (impl.hedge_cancel_pending_.exchange(false)) return true;
+
   std::string key = getString(ResponseHeader::Result);
   std::string header = response.get_header(key);
 
@@ -154,52 +165,157 @@ bool ASRProcessResponse::cancelRecog(SpeechRecognizer::Impl &impl,
   }
 
   // discard any pending result
-  impl.result_.clear();
+  impl.result_->clear();
+  impl.cancelCompleted();
+
+  impl.finishRecognition();
+  return true;
+}
+
+bool ASRProcessResponse::releaseSession(SpeechRecognizer::Impl &impl,
+                                        ASRMessageResponse &response) {
+  std::string key = getString(ResponseHeader::Result);
+  std::string header = response.get_header(key);
+
+  if (header.find(getString(ResultStatus::SUCCESS)) == std::string::npos) {
+    generateError(impl, response);
+    return false;
+  }
 
-  impl.recognizing_ = false;
-  impl.cv_.notify_one();
+  {
+    std::unique_lock<std::mutex> lk(impl.lock_);
+    impl.session_status_ = SpeechRecognizer::Impl::SessionStatus::kNone;
+  }
+  impl.cv_.notify_all();
+  return true;
+}
+
+bool ASRProcessResponse::startInputTimers(SpeechRecognizer::Impl &impl,
+                                          ASRMessageResponse &response) {
+  std::string key = getString(ResponseHeader::Result);
+  std::string header = response.get_header(key);
+
+  // Invalid action when the recognition ended before the timers were
+  // started, the request raced with the final result
+  if ((header.find(getString(ResultStatus::SUCCESS)) == std::string::npos) &&
+      (header.find(getString(ResultStatus::INVALID_ACTION)) ==
+       std::string::npos)) {
+    generateError(impl, response);
+    return false;
+  }
   return true;
 }
 
 bool ASRProcessResponse::sendAudioMessage(SpeechRecognizer::Impl &impl) {
-  int ret = 1;
+  // After a reconnection the audio of the utterance goes out first, in the
+  // longest frames: the server recognizes it faster than real time
+  if (impl.replay_pending_.exchange(false)) {
+    bool finished;
+    std::string audio = impl.replay_.restart(finished);
+    impl.replayed_bytes_ += audio.size();
+
+    size_t sent = 0;
+    do {
+      size_t size = std::min(impl.chunks_.maxFrame(), audio.size() - sent);
+      bool last_packet = finished && sent + size == audio.size();
+      if ((size > 0 || last_packet) &&
+          !sendAudioChunk(impl, audio.data() + sent, size, last_packet,
+                          UplinkClass::BULK))
+        return true;
+      sent += size;
+    } while (sent < audio.size());
+    if (finished) return true;
+  }
+
+  // audio read from the source and not sent yet
+  std::vector<char> pending;
+  bool last = false;
+  UplinkClass uplink = impl.chunks_.pacing() == AudioPacing::BATCH
+                           ? UplinkClass::BULK
+                           : UplinkClass::LIVE;
 
   do {
-    std::this_thread::sleep_for(
-          std::chrono::milliseconds(100)
-          );
-    ASRMessageRequest request(Method::SendAudio);
+    {
+      // Woken up right away when the recognition is canceled
+      std::unique_lock<std::mutex> l(impl.audio_lock_);
+      impl.audio_cv_.wait_for(l, impl.chunks_.pollInterval(), [&impl]() {
+        return impl.sendAudioMessage_terminate_.load();
+      });
+    }
 
     std::vector<char> buffer;
-    ret = impl.audio_src_->read(buffer);
+    int ret = impl.audio_src_->read(buffer);
+
+    last = (ret == -1);
+    // kept before sending, audio read by a thread stopped by a lost
+    // connection is replayed too
+    impl.replay_.append(buffer.data(), buffer.size());
+    if (last) impl.replay_.finish();
 
     if (impl.sendAudioMessage_terminate_) return true;
-    if (buffer.empty() && ret != -1) continue;
+    pending.insert(pending.end(), buffer.begin(), buffer.end());
 
-    std::string extra(buffer.begin(), buffer.end());
-    request.set_extra(extra);
-    request.set_header("Content-Length", std::to_string(extra.size()));
-    request.set_header("Content-Type", "application/octet-stream");
+    if (last && pending.empty()) {
+      if (!sendAudioChunk(impl, nullptr, 0, true, uplink)) return true;
+      break;
+    }
 
-    if (ret == -1) {
-      request.set_header("LastPacket", "true");
-    } else
-      request.set_header("LastPacket", "false");
+    size_t sent = 0;
+    size_t size;
+    while ((size = impl.chunks_.next(pending.size() - sent, last)) > 0) {
+      bool last_packet = last && sent + size == pending.size();
+      if (!sendAudioChunk(impl, pending.data() + sent, size, last_packet,
+                          uplink))
+        return true;
+      sent += size;
+    }
+    pending.erase(pending.begin(), pending.begin() + sent);
+  } while (!last);
 
-    std::string raw_message = request.raw();
+  return true;
+}
 
-    {
-      std::unique_lock<std::mutex> l(impl.lock_);
-      impl.logger_.write(
-            websocketpp::log::elevel::info,
-            "[SEND] " + request.get_start_line() + "\nContent-Length: " +
-            request.get_header("Content-Length") + "\nLastPacket: " +
-            request.get_header("LastPacket") + "\n");
-    }
+bool ASRProcessResponse::sendAudioChunk(SpeechRecognizer::Impl &impl,
+                                        const char *data, size_t size,
+                                        bool last, UplinkClass uplink) {
+  ASRMessageRequest request(Method::SendAudio);
+
+  std::string extra(data, data + size);
+  request.set_extra(extra);
+  request.set_header("Content-Length", std::to_string(extra.size()));
+  request.set_header("Content-Type", "application/octet-stream");
+
+  if (last) {
+    request.set_header("LastPacket", "true");
+  } else
+    request.set_header("LastPacket", "false");
+
+  std::string raw_message = request.raw();
+
+  // Held back while the class of audio is over its share of the uplink,
+  // woken up right away when the recognition is canceled
+  std::chrono::microseconds hold =
+      UplinkShaper::global().reserve(uplink, raw_message.size());
+  if (hold.count() > 0) {
+    impl.uplink_throttled_us_ += hold.count();
+    std::unique_lock<std::mutex> l(impl.audio_lock_);
+    if (impl.audio_cv_.wait_for(l, hold, [&impl]() {
+          return impl.sendAudioMessage_terminate_.load();
+        }))
+      return false;
+  }
 
-    impl.sendMessage(raw_message);
-  } while (ret != -1);
+  {
+    std::unique_lock<std::mutex> l(impl.lock_);
+    impl.logger_.write(
+          websocketpp::log::elevel::info,
+          "[SEND] " + request.get_start_line() + "\nContent-Length: " +
+          request.get_header("Content-Length") + "\nLastPacket: " +
+          request.get_header("LastPacket") + "\n");
+  }
 
+  if (!impl.sendAudio(raw_message)) return false;
+  if (last) impl.audioFinished();
   return true;
 }
 
@@ -270,9 +386,9 @@ bool ASRProcessStartSpeech::handle(SpeechRecognizer::Impl &impl,
   }
 
   // invoking callback
-  for (std::unique_ptr<RecognitionListener> &listener : impl.listener_) {
-    listener->onSpeechStart(0);
-  }
+  impl.notifyListeners([](RecognitionListener &listener) {
+    listener.onSpeechStart(0);
+  });
 
   return true;
 }
@@ -285,9 +401,9 @@ bool ASRProcessEndSpeech::handle(SpeechRecognizer::Impl &impl,
   }
 
   // invoking callback
-  for (std::unique_ptr<RecognitionListener> &listener : impl.listener_) {
-    listener->onSpeechStop(0);
-  }
+  impl.notifyListeners([](RecognitionListener &listener) {
+    listener.onSpeechStop(0);
+  });
 
   return true;
 }
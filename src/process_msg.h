@@ -17,6 +17,8 @@
 #ifndef SRC_PROCESS_MSG_H_
 #define SRC_PROCESS_MSG_H_
 
+#include <cpqd/asr-client/uplink_shaper.h>
+
 #include <memory>
 #include <string>
 
@@ -58,6 +60,9 @@ class ASRProcessResponse : public ASRProcessMsg {
 
   bool handle(SpeechRecognizer::Impl& impl, ASRMessageResponse& response);
 
+  /// Body of the audio thread of a recognition
+  static bool sendAudioMessage(SpeechRecognizer::Impl& impl);
+
  private:
   bool createSession(SpeechRecognizer::Impl& impl,
                      ASRMessageResponse& response);
@@ -69,7 +74,15 @@ class ASRProcessResponse : public ASRProcessMsg {
 
   bool cancelRecog(SpeechRecognizer::Impl& impl, ASRMessageResponse& response);
 
-  bool sendAudioMessage(SpeechRecognizer::Impl& impl);
+  bool releaseSession(SpeechRecognizer::Impl& impl,
+                      ASRMessageResponse& response);
+
+  bool startInputTimers(SpeechRecognizer::Impl& impl,
+                        ASRMessageResponse& response);
+
+  /// Send an audio message, once the uplink shaper lets it go
+  static bool sendAudioChunk(SpeechRecognizer::Impl& impl, const char* data,
+                             size_t size, bool last, UplinkClass uplink);
 
   void generateError(SpeechRecognizer::Impl& impl,
                      ASRMessageResponse& response);
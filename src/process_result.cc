@@ -18,65 +18,12 @@
 
 #include <cpqd/asr-client/recognition_exception.h>
 
-#include "json11.hpp"
+#include <memory>
+#include <utility>
 
+#include "src/asr_result_decoder.h"
 #include "src/message_utils.h"
 
-RecognitionResult recognitionResultFromJson(json11::Json json){
-  RecognitionResult res(json["result_status"].string_value());
-  for (auto &k : json["alternatives"].array_items()) {
-    RecognitionResult::Alternative alt;
-
-    int score = k["score"].int_value();
-    alt.confidence(score).text(k["text"].string_value());
-    for (auto &interp : k["interpretations"].array_items()) {
-      alt.addInterpretation(interp.string_value());
-    }
-    for (auto &word : k["words"].array_items()) {
-      alt.addWord(word["text"].string_value(),
-                  word["score"].int_value(),
-                  word["start_time"].number_value(),
-                  word["end_time"].number_value());
-    }
-    res.addAlternatives(alt);
-    // age scores
-    auto as= json["age_scores"];
-    if (as.is_object() && !as.object_items().empty()) {
-      std::string age = std::to_string(as["age"].number_value());
-      res.getClassifiers().setAge(age);
-    }
-    // emotion scores
-    auto es= json["emotion_scores"];
-    if (es.is_object() && !es.object_items().empty()) {
-      std::string emotion = es["emotion"].string_value();
-      res.getClassifiers().setEmotion(emotion);
-    }
-    // gender scores
-    auto gs= json["gender_scores"];
-    if (gs.is_object() && !gs.object_items().empty()) {
-      std::string gender = gs["gender"].string_value();
-      res.getClassifiers().setGender(gender);
-    }
-  }
-
-  return res;
-}
-
-PartialRecognition partialRecognitionFromJson(json11::Json json){
-  // Partial result case
-  auto k = json["alternatives"].array_items()[0];
-  PartialRecognition partial;
-  partial.text_ = k["text"].string_value();
-
-  // Default segment index is 0 (pre-3.0)
-  partial.speech_segment_index_ = 0;
-  if(json["segment_index"].is_number()){
-    partial.speech_segment_index_ = json["segment_index"].int_value();
-  }
-  return partial;
-}
-
-
 bool ASRProcessResult::handle(SpeechRecognizer::Impl &impl,
                               ASRMessageResponse &response) {
   std::string method = split(response.get_start_line(), ' ')[2];
@@ -101,76 +48,183 @@ bool ASRProcessResult::handle(SpeechRecognizer::Impl &impl,
 //  std::cout << response.get_extra() << std::endl;
 
   if (value == RecognitionResult::getString(ResultStatus::CANCELED)) {
+    // canceled because a hedge won, the recognition is already over
+    if (impl.hedge_cancel_pending_ ||
+        impl.hedge_ == SpeechRecognizer::Impl::Hedge::kHedge)
+      return false;
+
     // On CANCEL, do not populate result list
-    impl.recognizing_ = false;
-    impl.cv_.notify_one();
+    impl.cancelCompleted();
+    impl.finishRecognition();
     return false;
   }
+
+  bool processing =
+      value == RecognitionResult::getString(ResultStatus::PROCESSING);
+  if (processing && impl.partials_.enabled() &&
+      !response.get_extra().empty()) {
+    // Coalesced partials are only scanned here, the one delivered is decoded
+    // by the coalescer
+    ASRResultDecoder::Routing routing;
+    if (!impl.decoder_.scan(response.get_extra(), routing)) {
+      impl.recognitionError(RecognitionError::Code::FAILURE,
+                            "Invalid recognition result body");
+      return false;
+    }
+    if (!routing.has_final_result || !routing.final_result) {
+      impl.offerPartial({response.share_extra(), routing});
+      return true;
+    }
+  }
+
+  if (impl.raw_results_) {
+    return handleRaw(impl, response, value);
+  }
   else if (response.get_extra().empty()){
     // On empty body, assume no result with only the header status
-    RecognitionResult res(value);
-    impl.result_.push_back(res);
+    if (!impl.claimResult(true)) return false;
+    std::shared_ptr<RecognitionResult> res =
+        std::make_shared<RecognitionResult>(value);
 
     // invoking result callback
-    for (RecognitionResult &res : impl.result_) {
-      for (std::unique_ptr<RecognitionListener> &listener : impl.listener_) {
-        listener->onRecognitionResult(res);
-      }
-    }
+    notifyResult(impl, res);
+    impl.partials_.reset();
+    impl.pushResult({std::move(res), nullptr});
 
-    impl.recognizing_ = false;
-    impl.cv_.notify_one();
+    impl.finishRecognition();
     return false;
   }
   else {
-    std::string err;
-    json11::Json json = json11::Json::parse(response.get_extra(), err);
+    // Partials are decoded up to the text of the best alternative only. The
+    // body has the last word on whether a result is final (3.0), so the
+    // decoding mode is only a guess taken from the header.
+    ASRResultDecoder::Routing routing;
+    RecognitionResult res;
+    PartialRecognition partial;
+    bool partial_decoded = processing;
+    bool valid = partial_decoded
+        ? impl.decoder_.decodePartial(response.get_extra(), routing, partial)
+        : impl.decoder_.decode(response.get_extra(), routing, res);
+    if (!valid) {
+      impl.recognitionError(RecognitionError::Code::FAILURE,
+                            "Invalid recognition result body");
+      return false;
+    }
 
     // Behaviour of variables pre-3.0
     bool final_result = value == RecognitionResult::getString(ResultStatus::RECOGNIZED);
     bool last_segment = true;
 
     // On 3.0, the aforedefined variables are present in the body of the message
-    if(json["final_result"].is_bool())
-      final_result = json["final_result"].bool_value();
-    if(json["last_segment"].is_bool())
-      last_segment = json["last_segment"].bool_value();
+    if(routing.has_final_result)
+      final_result = routing.final_result;
+    if(routing.has_last_segment)
+      last_segment = routing.last_segment;
 
     if (final_result) {
-      // Final result case
-      auto res = recognitionResultFromJson(json);
-      if(json["start_time"].is_number())
-        res.setStartTime(json["start_time"].number_value());
-      if(json["end_time"].is_number())
-        res.setEndTime(json["end_time"].number_value());
-      impl.result_.push_back(res);
-      res.setLastSpeechSegment(last_segment);
+      // Final result case, unless the other side of a hedge was faster
+      if (!impl.claimResult(last_segment)) return true;
+      if (partial_decoded)
+        impl.decoder_.decode(response.get_extra(), routing, res);
+
+      // The listeners share the result queued for the application
+      std::shared_ptr<RecognitionResult> shared_res =
+          std::make_shared<RecognitionResult>(std::move(res));
 
       // invoking result callback
-      for (std::unique_ptr<RecognitionListener>& listener : impl.listener_) {
-        listener->onRecognitionResult(res);
-      }
+      notifyResult(impl, shared_res);
+
+      // A final result supersedes the partials of its segment
+      impl.partials_.reset();
+      if (!last_segment) impl.segmentRecognized(routing);
+      impl.pushResult({std::move(shared_res), nullptr});
 
       // Default behaviour in the absence of the "last_segment" field in json is
       // assuming last_segment=true (pre-3.0)
       if(last_segment){
-        impl.recognizing_ = false;
-        impl.cv_.notify_one();
+        impl.finishRecognition();
       }
 
       return true;
     } else {
-      auto partial = partialRecognitionFromJson(json);
+      if (!partial_decoded)
+        ASRResultDecoder::toPartial(routing, res, partial);
+      if (!impl.partials_.accept(partial))
+        return true;
 
       // invoking partial result callback
-      for (std::unique_ptr<RecognitionListener>& listener : impl.listener_) {
-        listener->onPartialRecognition(partial);
-      }
+      std::shared_ptr<const PartialRecognition> shared_partial =
+          std::make_shared<PartialRecognition>(std::move(partial));
+      impl.notifyListeners([shared_partial](RecognitionListener& listener) {
+        listener.onPartialRecognition(*shared_partial);
+      });
       return true;
     }
   }
 }
 
+bool ASRProcessResult::handleRaw(SpeechRecognizer::Impl &impl,
+                                 ASRMessageResponse &response,
+                                 const std::string &result_status) {
+  bool processing =
+      result_status == RecognitionResult::getString(ResultStatus::PROCESSING);
+
+  // Behaviour of variables pre-3.0, an empty body is a final result
+  bool final_result = response.get_extra().empty() || result_status ==
+      RecognitionResult::getString(ResultStatus::RECOGNIZED);
+  bool last_segment = true;
+
+  // Only the routing fields of the body are read, on 3.0 they override the
+  // values taken from the header
+  ASRResultDecoder::Routing routing;
+  if (!response.get_extra().empty()) {
+    if (!impl.decoder_.scan(response.get_extra(), routing)) {
+      impl.recognitionError(RecognitionError::Code::FAILURE,
+                            "Invalid recognition result body");
+      return false;
+    }
+    if (routing.has_final_result)
+      final_result = routing.final_result;
+    if (routing.has_last_segment)
+      last_segment = routing.last_segment;
+  }
+
+  // the other side of a hedge was faster
+  if (final_result && !impl.claimResult(last_segment)) return true;
+
+  RawRecognitionResult raw(response.share_extra(),
+                           processing
+                               ? ResultStatus::PROCESSING
+                               : RecognitionResult(result_status).getCode(),
+                           final_result, routing.segment_index, last_segment);
+
+  impl.notifyListeners([raw](RecognitionListener& listener) {
+    listener.onRawRecognitionResult(raw);
+  });
+
+  if (final_result) {
+    // Materialized when taken from the queue, only if the application asks
+    impl.partials_.reset();
+    if (!last_segment) impl.segmentRecognized(routing);
+    impl.pushResult(
+        {nullptr, std::make_shared<const RawRecognitionResult>(std::move(raw)),
+         impl.decoder_.options()});
+
+    if (last_segment) {
+      impl.finishRecognition();
+    }
+  }
+  return true;
+}
+
+void ASRProcessResult::notifyResult(
+    SpeechRecognizer::Impl &impl,
+    std::shared_ptr<const RecognitionResult> result) {
+  impl.notifyListeners([result](RecognitionListener& listener) {
+    listener.onRecognitionResult(*result);
+  });
+}
+
 std::string ASRProcessResult::getString(ASRProcessResult::Header hdr) {
   switch (hdr) {
   case Header::Handle:
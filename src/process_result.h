@@ -20,6 +20,7 @@
 #include <cpqd/asr-client/recognition_result.h>
 #include "src/process_msg.h"
 
+#include <memory>
 #include <string>
 
 class ASRProcessResult : public ASRProcessMsg {
@@ -41,6 +42,13 @@ class ASRProcessResult : public ASRProcessMsg {
   bool handle(SpeechRecognizer::Impl& impl, ASRMessageResponse& response);
 
  private:
+  /// Deliver the result body without decoding it
+  bool handleRaw(SpeechRecognizer::Impl& impl, ASRMessageResponse& response,
+                 const std::string& result_status);
+
+  void notifyResult(SpeechRecognizer::Impl& impl,
+                    std::shared_ptr<const RecognitionResult> result);
+
   std::string getString(Header hdr);
   std::string getString(SessionStatus st);
 };
@@ -164,91 +164,91 @@ RecognitionConfig &RecognitionConfig::operator=(
   return *this;
 }
 
-unsigned int RecognitionConfig::confidenceThreshold() {
+unsigned int RecognitionConfig::confidenceThreshold() const {
   return properties_.confidence_threshold_;
 }
 
-unsigned int RecognitionConfig::maxSentences() {
+unsigned int RecognitionConfig::maxSentences() const {
   return properties_.max_sentences_;
 }
 
-unsigned int RecognitionConfig::noInputTimeoutMilliseconds() {
+unsigned int RecognitionConfig::noInputTimeoutMilliseconds() const {
   return properties_.no_input_timeout_milliseconds_;
 }
 
-unsigned int RecognitionConfig::recognitionTimeoutSeconds() {
+unsigned int RecognitionConfig::recognitionTimeoutSeconds() const {
   return properties_.recog_timeout_seconds_;
 }
 
-bool RecognitionConfig::noInputTimeoutEnabled() {
+bool RecognitionConfig::noInputTimeoutEnabled() const {
   return properties_.no_input_timeout_enabled_;
 }
 
-bool RecognitionConfig::recognitionTimeoutEnabled() {
+bool RecognitionConfig::recognitionTimeoutEnabled() const {
   return properties_.recog_timeout_enabled_;
 }
 
-bool RecognitionConfig::inferAgeEnabled() {
+bool RecognitionConfig::inferAgeEnabled() const {
   return properties_.infer_age_enabled_;
 }
 
-bool RecognitionConfig::inferEmotionEnabled() {
+bool RecognitionConfig::inferEmotionEnabled() const {
   return properties_.infer_emotion_enabled_;
 }
 
-bool RecognitionConfig::inferGenderEnabled() {
+bool RecognitionConfig::inferGenderEnabled() const {
   return properties_.infer_gender_enabled_;
 }
 
-unsigned int RecognitionConfig::headMarginMilliseconds() {
+unsigned int RecognitionConfig::headMarginMilliseconds() const {
   return properties_.head_margin_milliseconds_;
 }
 
-unsigned int RecognitionConfig::tailMarginMilliseconds() {
+unsigned int RecognitionConfig::tailMarginMilliseconds() const {
   return properties_.tail_margin_milliseconds_;
 }
 
-unsigned int RecognitionConfig::waitEndMilliseconds() {
+unsigned int RecognitionConfig::waitEndMilliseconds() const {
   return properties_.wait_end_milliseconds_;
 }
 
-bool RecognitionConfig::continuousMode() {
+bool RecognitionConfig::continuousMode() const {
   return properties_.continuous_mode_;
 }
 
-unsigned int RecognitionConfig::maxSegmentDuration() {
+unsigned int RecognitionConfig::maxSegmentDuration() const {
   return properties_.max_segment_duration_;
 }
 
-bool RecognitionConfig::startInputTimers() {
+bool RecognitionConfig::startInputTimers() const {
   return properties_.start_input_timers_;
 }
 
-unsigned int RecognitionConfig::endpointerAutoLevelLen() {
+unsigned int RecognitionConfig::endpointerAutoLevelLen() const {
   return properties_.endpointer_auto_level_len_;
 }
 
-unsigned int RecognitionConfig::endpointerLevelMode() {
+unsigned int RecognitionConfig::endpointerLevelMode() const {
   return properties_.endpointer_level_mode_;
 }
 
-unsigned int RecognitionConfig::endpointerLevelThreshold() {
+unsigned int RecognitionConfig::endpointerLevelThreshold() const {
   return properties_.endpointer_level_threshold_;
 }
 
-bool RecognitionConfig::verifyBufferUtterance() {
+bool RecognitionConfig::verifyBufferUtterance() const {
   return properties_.verify_buffer_utterance_;
 }
 
-std::string  RecognitionConfig::accountTag() {
+std::string  RecognitionConfig::accountTag() const {
   return properties_.account_tag_;
 }
 
-std::string  RecognitionConfig::channelIdentifier() {
+std::string  RecognitionConfig::channelIdentifier() const {
   return properties_.channel_identifier_;
 }
 
-std::string  RecognitionConfig::mediaType() {
+std::string  RecognitionConfig::mediaType() const {
   return properties_.media_type_;
 }
 
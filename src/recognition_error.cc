@@ -35,6 +35,9 @@ std::string RecognitionError::getString() const {
     case Code::ACTIVE_RECOGNITION:
       msg = "ACTIVE_RECOGNITION";
       break;  
+    case Code::OVERLOADED:
+      msg = "OVERLOADED";
+      break;
   }
 
   if (!message_.empty()) msg += ": " + message_;
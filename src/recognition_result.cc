@@ -16,6 +16,12 @@
 
 #include <cpqd/asr-client/recognition_result.h>
 
+#include <cpqd/asr-client/recognition_exception.h>
+
+#include <utility>
+
+#include "src/asr_result_decoder.h"
+
 RecognitionResult::RecognitionResult()
   : result_status_(Code::NO_MATCH)
 {}
@@ -47,49 +53,53 @@ RecognitionResult::RecognitionResult(std::string status_string){
     result_status_ = Code::FAILURE;
 }
 
-int RecognitionResult::Alternative::getConfidence() { return confidence_; }
+int RecognitionResult::Alternative::getConfidence() const {
+  return confidence_;
+}
 
-std::string RecognitionResult::Alternative::getText() { return text_; }
+const std::string& RecognitionResult::Alternative::getText() const {
+  return text_;
+}
 
-std::vector<Interpretation>
-RecognitionResult::Alternative::getInterpretations() {
+const std::vector<Interpretation>&
+RecognitionResult::Alternative::getInterpretations() const {
   return interpretations_;
 }
 
-std::vector<Word>
-RecognitionResult::Alternative::getWords() {
+const std::vector<Word>&
+RecognitionResult::Alternative::getWords() const {
   return words_;
 }
 
 RecognitionResult::Alternative &RecognitionResult::Alternative::languageModel(
     std::string lang_model) {
-  lang_model_ = lang_model;
+  lang_model_ = std::move(lang_model);
   return *this;
 }
 
 RecognitionResult::Alternative &RecognitionResult::Alternative::text(
     std::string text) {
-  text_ = text;
+  text_ = std::move(text);
   return *this;
 }
 
 RecognitionResult::Alternative &
 RecognitionResult::Alternative::addInterpretation(std::string text,
                                                   int confidence) {
-  interpretations_.push_back({text, confidence});
+  interpretations_.push_back({std::move(text), confidence});
   return *this;
 }
 
 RecognitionResult::Alternative &
 RecognitionResult::Alternative::addWord(Word word) {
-  words_.push_back(word);
+  words_.push_back(std::move(word));
   return *this;
 }
 
 RecognitionResult::Alternative &
 RecognitionResult::Alternative::addWord(std::string text, int confidence,
                                         float start_time, float end_time) {
-  words_.push_back({text, confidence, start_time, end_time});
+  words_.push_back({std::move(text), confidence, start_time, end_time});
   return *this;
 }
 
@@ -107,6 +117,14 @@ RecognitionResult &RecognitionResult::addAlternatives(const Alternative &alt) {
   return *this;
 }
 
+RecognitionResult &RecognitionResult::addAlternatives(Alternative &&alt) {
+  if (result_status_ == Code::NO_MATCH)
+    result_status_ = Code::RECOGNIZED;
+
+  alternatives_.push_back(std::move(alt));
+  return *this;
+}
+
 std::string RecognitionResult::getString(RecognitionResult::Code st) {
   switch (st) {
   case Code::PROCESSING:
@@ -132,38 +150,58 @@ std::string RecognitionResult::getString(RecognitionResult::Code st) {
   }
 }
 
-std::string RecognitionResult::Classifier::getAge() {
+RawRecognitionResult::RawRecognitionResult(
+    std::shared_ptr<const std::string> body, RecognitionResult::Code code,
+    bool final_result, int segment_index, bool last_segment)
+  : body_(body ? std::move(body) : std::make_shared<const std::string>()),
+    code_(code),
+    final_result_(final_result),
+    segment_index_(segment_index),
+    last_segment_(last_segment)
+{}
+
+RecognitionResult RawRecognitionResult::materialize() const {
+  RecognitionResult res;
+  ASRResultDecoder decoder;
+  if (!decoder.materialize(*this, res)) {
+    throw RecognitionException(RecognitionError::Code::FAILURE,
+                               "Invalid recognition result body");
+  }
+  return res;
+}
+
+const std::string& RecognitionResult::Classifier::getAge() const {
   return age_;
 }
 
-std::string RecognitionResult::Classifier::getEmotion() {
+const std::string& RecognitionResult::Classifier::getEmotion() const {
   return emotion_;
 }
 
-std::string RecognitionResult::Classifier::getGender() {
+const std::string& RecognitionResult::Classifier::getGender() const {
   return gender_;
 }
 
-void RecognitionResult::Classifier::setAge(std::string& age) {
-  age_ = age;
+void RecognitionResult::Classifier::setAge(std::string age) {
+  age_ = std::move(age);
 }
 
-void RecognitionResult::Classifier::setEmotion(std::string& emotion) {
-  emotion_ = emotion;
+void RecognitionResult::Classifier::setEmotion(std::string emotion) {
+  emotion_ = std::move(emotion);
 }
 
-void RecognitionResult::Classifier::setGender(std::string& gender) {
-  gender_ = gender;
+void RecognitionResult::Classifier::setGender(std::string gender) {
+  gender_ = std::move(gender);
 }
 
-bool RecognitionResult::Classifier::hasAge() {
+bool RecognitionResult::Classifier::hasAge() const {
   return !age_.empty();
 }
 
-bool RecognitionResult::Classifier::hasEmotion() {
+bool RecognitionResult::Classifier::hasEmotion() const {
   return !emotion_.empty();
 }
 
-bool RecognitionResult::Classifier::hasGender() {
+bool RecognitionResult::Classifier::hasGender() const {
   return !gender_.empty();
 }
@@ -0,0 +1,43 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include "src/reconnect_backoff.h"
+
+#include <algorithm>
+
+const unsigned int ReconnectBackoff::kDefaultBaseMilliseconds;
+const unsigned int ReconnectBackoff::kDefaultCapMilliseconds;
+
+ReconnectBackoff::ReconnectBackoff() : random_(std::random_device()()) {}
+
+void ReconnectBackoff::configure(std::chrono::milliseconds base,
+                                 std::chrono::milliseconds cap) {
+  base_ = base;
+  cap_ = cap;
+}
+
+std::chrono::milliseconds ReconnectBackoff::bound(unsigned int attempt) const {
+  // doubling stops at the cap, so it never overflows
+  std::chrono::milliseconds bound = base_;
+  for (unsigned int i = 0; i < attempt && bound < cap_; ++i) bound *= 2;
+  return std::min(bound, cap_);
+}
+
+std::chrono::milliseconds ReconnectBackoff::delay(unsigned int attempt) {
+  std::uniform_int_distribution<int64_t> uniform(0, bound(attempt).count());
+  std::unique_lock<std::mutex> lk(lock_);
+  return std::chrono::milliseconds(uniform(random_));
+}
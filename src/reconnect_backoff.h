@@ -0,0 +1,54 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef SRC_RECONNECT_BACKOFF_H_
+#define SRC_RECONNECT_BACKOFF_H_
+
+#include <chrono>
+#include <mutex>
+#include <random>
+
+/// Delay before a reconnection attempt
+/**
+ * Exponential backoff with full jitter: the delay of attempt n is drawn
+ * uniformly from [0, min(cap, base * 2^n)], so many recognizers losing
+ * their connections at once don't reconnect in lockstep.
+ */
+class ReconnectBackoff {
+ public:
+  static const unsigned int kDefaultBaseMilliseconds = 100;
+  static const unsigned int kDefaultCapMilliseconds = 2000;
+
+  ReconnectBackoff();
+
+  void configure(std::chrono::milliseconds base,
+                 std::chrono::milliseconds cap);
+
+  /// Delay before the given attempt, counted from 0
+  std::chrono::milliseconds delay(unsigned int attempt);
+
+  /// Upper bound of the delay of the given attempt
+  std::chrono::milliseconds bound(unsigned int attempt) const;
+
+ private:
+  std::chrono::milliseconds base_{kDefaultBaseMilliseconds};
+  std::chrono::milliseconds cap_{kDefaultCapMilliseconds};
+
+  std::mutex lock_;
+  std::minstd_rand random_;
+};
+
+#endif  // SRC_RECONNECT_BACKOFF_H_
@@ -0,0 +1,84 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include "src/replay_window.h"
+
+#include <algorithm>
+
+void ReplayWindow::configure(size_t capacity) {
+  std::unique_lock<std::mutex> lk(lock_);
+  capacity_ = capacity;
+}
+
+void ReplayWindow::reset() {
+  std::unique_lock<std::mutex> lk(lock_);
+  data_.clear();
+  finished_ = false;
+  overflowed_ = false;
+  window_start_ = 0;
+  session_start_ = 0;
+}
+
+void ReplayWindow::append(const char* data, size_t size) {
+  std::unique_lock<std::mutex> lk(lock_);
+  if (capacity_ == 0 || overflowed_) return;
+  if (data_.size() + size > capacity_) {
+    overflowed_ = true;
+    std::string().swap(data_);
+    return;
+  }
+  data_.append(data, size);
+}
+
+void ReplayWindow::finish() {
+  std::unique_lock<std::mutex> lk(lock_);
+  finished_ = true;
+}
+
+void ReplayWindow::trim(uint64_t offset) {
+  std::unique_lock<std::mutex> lk(lock_);
+  if (overflowed_) return;
+  uint64_t end = session_start_ + offset;
+  if (end <= window_start_) return;
+
+  size_t drop = static_cast<size_t>(
+      std::min<uint64_t>(end - window_start_, data_.size()));
+  data_.erase(0, drop);
+  window_start_ += drop;
+}
+
+bool ReplayWindow::replayable() const {
+  std::unique_lock<std::mutex> lk(lock_);
+  return capacity_ > 0 && !overflowed_;
+}
+
+std::string ReplayWindow::restart(bool& finished) {
+  std::unique_lock<std::mutex> lk(lock_);
+  session_start_ = window_start_;
+  finished = finished_;
+  return data_;
+}
+
+std::string ReplayWindow::snapshot(bool& finished) const {
+  std::unique_lock<std::mutex> lk(lock_);
+  finished = finished_;
+  return data_;
+}
+
+size_t ReplayWindow::size() const {
+  std::unique_lock<std::mutex> lk(lock_);
+  return data_.size();
+}
@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef SRC_REPLAY_WINDOW_H_
+#define SRC_REPLAY_WINDOW_H_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/// Audio of the current utterance, kept to be sent again on a new connection
+/**
+ * Every byte read from the audio source is appended. When the connection
+ * is lost the window is sent again to a new session, whose audio stream
+ * starts at the beginning of the window. Segments the server already
+ * recognized are trimmed off, their results are not produced twice.
+ *
+ * A window that outgrows its capacity can't be replayed anymore, for the
+ * rest of the recognition. Thread safe: audio is appended by the audio
+ * thread and segments are trimmed by the I/O thread.
+ */
+class ReplayWindow {
+ public:
+  ReplayWindow() = default;
+
+  ReplayWindow(const ReplayWindow&) = delete;
+  ReplayWindow& operator=(const ReplayWindow&) = delete;
+
+  /// Bytes the window may hold, 0 disables it
+  void configure(size_t capacity);
+
+  bool enabled() const { return capacity_ > 0; }
+
+  /// Empty the window for a new recognition
+  void reset();
+
+  /// Keep audio read from the source
+  void append(const char* data, size_t size);
+
+  /// The audio source has ended, the window holds the rest of the stream
+  void finish();
+
+  /// Drop the audio of the segments recognized so far
+  /**
+   * @param [in] offset End of the last recognized segment, in bytes from
+   *   the start of the audio stream of the current session.
+   */
+  void trim(uint64_t offset);
+
+  /// Whether the utterance can be sent again
+  bool replayable() const;
+
+  /// Take the audio to send to a new session
+  /**
+   * The audio stream of the new session starts at the beginning of the
+   * window, offsets given to trim() are then relative to it.
+   *
+   * @param [out] finished Whether the audio source had ended.
+   */
+  std::string restart(bool& finished);
+
+  /// Copy the audio, to be sent to a second session alongside this one
+  /**
+   * @param [out] finished Whether the audio source had ended.
+   */
+  std::string snapshot(bool& finished) const;
+
+  /// Bytes held
+  size_t size() const;
+
+ private:
+  mutable std::mutex lock_;
+  size_t capacity_ = 0;
+  std::string data_;
+  bool finished_ = false;
+  bool overflowed_ = false;
+
+  // Stream offsets, counted from the first byte of the recognition
+  uint64_t window_start_ = 0;
+  uint64_t session_start_ = 0;
+};
+
+#endif  // SRC_REPLAY_WINDOW_H_
@@ -0,0 +1,73 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include "src/result_queue.h"
+
+#include <utility>
+
+ResultQueue::ResultQueue(size_t capacity, ResultOverflow overflow)
+    : queue_(capacity), capacity_(capacity), overflow_(overflow) {}
+
+bool ResultQueue::push(Entry entry) {
+  // the underlying queue rounds its capacity up to a power of two
+  while (queue_.size() >= capacity_ || !queue_.push(std::move(entry))) {
+    switch (overflow_) {
+    case ResultOverflow::DROP_OLDEST: {
+      Entry oldest;
+      if (queue_.pop(oldest)) ++dropped_;
+      break;
+    }
+    case ResultOverflow::DROP_NEWEST:
+      ++dropped_;
+      return true;
+    case ResultOverflow::FAIL:
+      ++dropped_;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ResultQueue::pop(RecognitionResult& result) {
+  Entry entry;
+  while (queue_.pop(entry)) {
+    if (!entry.raw_) {
+      if (entry.result_.use_count() == 1) {
+        result = std::move(*entry.result_);
+      } else {
+        result = *entry.result_;
+      }
+      return true;
+    }
+    // the caller reports the failure, this may run on the I/O thread
+    ASRResultDecoder decoder(entry.decoder_options_);
+    if (decoder.materialize(*entry.raw_, result)) return true;
+    ++dropped_;
+    ++invalid_;
+  }
+  return false;
+}
+
+void ResultQueue::clear() {
+  Entry entry;
+  while (queue_.pop(entry)) {
+  }
+}
+
+void ResultQueue::metrics(RecognizerMetrics& metrics) const {
+  metrics.result_queue_depth_ = queue_.size();
+  metrics.results_dropped_ = dropped_;
+}
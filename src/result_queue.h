@@ -0,0 +1,94 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef SRC_RESULT_QUEUE_H_
+#define SRC_RESULT_QUEUE_H_
+
+#include <cpqd/asr-client/recognition_result.h>
+#include <cpqd/asr-client/recognizer_metrics.h>
+#include <cpqd/asr-client/speech_recog.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "src/asr_result_decoder.h"
+#include "src/bounded_queue.h"
+
+/// Final results of a recognition, waiting to be consumed
+/**
+ * Written by the I/O thread, read by waitRecognitionResult() and
+ * nextResult() without sharing a lock with the writer. Memory is bounded by
+ * the capacity, results that do not fit are handled according to the
+ * overflow policy.
+ */
+class ResultQueue {
+ public:
+  static const size_t kDefaultCapacity = 256;
+
+  /// Either a decoded result or a raw one, materialized when taken
+  struct Entry {
+    Entry() = default;
+    Entry(std::shared_ptr<RecognitionResult> result,
+          std::shared_ptr<const RawRecognitionResult> raw,
+          const ASRResultDecoder::Options& decoder_options = {})
+        : result_(std::move(result)),
+          raw_(std::move(raw)),
+          decoder_options_(decoder_options) {}
+
+    std::shared_ptr<RecognitionResult> result_;
+    std::shared_ptr<const RawRecognitionResult> raw_;
+    // the recognizer options a raw result is materialized with
+    ASRResultDecoder::Options decoder_options_;
+  };
+
+  explicit ResultQueue(size_t capacity = kDefaultCapacity,
+                       ResultOverflow overflow = ResultOverflow::DROP_OLDEST);
+
+  /// @return false if the queue is full and the policy is FAIL
+  bool push(Entry entry);
+
+  /// Take the oldest result
+  /**
+   * Results no longer shared with a pending listener callback are moved
+   * out, the others are copied. A raw result whose body does not decode
+   * is dropped and counted, see takeInvalid().
+   *
+   * @return false if the queue is empty.
+   */
+  bool pop(RecognitionResult& result);
+
+  /// Number of raw results dropped by pop() since the last call
+  size_t takeInvalid() { return invalid_.exchange(0); }
+
+  bool empty() const { return queue_.empty(); }
+
+  /// Drop every queued result
+  void clear();
+
+  /// Fill the result queue fields of a metrics snapshot
+  void metrics(RecognizerMetrics& metrics) const;
+
+ private:
+  BoundedQueue<Entry> queue_;
+  const size_t capacity_;
+  const ResultOverflow overflow_;
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<size_t> invalid_{0};
+};
+
+#endif  // SRC_RESULT_QUEUE_H_
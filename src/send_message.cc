@@ -39,113 +39,10 @@ void ASRSendMessage::createSession(SpeechRecognizer::Impl &impl) {
 void ASRSendMessage::setParameters(SpeechRecognizer::Impl &impl) {
   ASRMessageRequest request(Method::SetParameters);
 
-  unsigned int confidence_threshold = impl.config_->confidenceThreshold();
-  unsigned int max_sentences = impl.config_->maxSentences();
-  unsigned int no_input_timeout_milliseconds =
-      impl.config_->noInputTimeoutMilliseconds();
-  unsigned int recog_timeout_seconds = impl.config_->recognitionTimeoutSeconds();
-  bool no_input_timeout_enabled = impl.config_->noInputTimeoutEnabled();
-  bool recog_timeout_enabled = impl.config_->recognitionTimeoutEnabled();
-  bool infer_age_enabled = impl.config_->inferAgeEnabled();
-  bool infer_emotion_enabled = impl.config_->inferEmotionEnabled();
-  bool infer_gender_enabled = impl.config_->inferGenderEnabled();
-  unsigned int head_margin_milliseconds = impl.config_->headMarginMilliseconds();
-  unsigned int tail_margin_milliseconds = impl.config_->tailMarginMilliseconds();
-  unsigned int wait_end_milliseconds = impl.config_->waitEndMilliseconds();
-  bool continuous_mode = impl.config_->continuousMode();
-  unsigned int max_segment_duration = impl.config_->maxSegmentDuration();
-  bool start_input_timers = impl.config_->startInputTimers();
-  unsigned int endpointer_auto_level_len = impl.config_->endpointerAutoLevelLen();
-  unsigned int endpointer_level_mode = impl.config_->endpointerLevelMode();
-  unsigned int endpointer_level_threshold = impl.config_->endpointerLevelThreshold();
-  bool verify_buffer_utterance = impl.config_->verifyBufferUtterance();
-  std::string account_tag = impl.config_->accountTag();
-  std::string channel_identifier = impl.config_->channelIdentifier();
-  std::string media_type = impl.config_->mediaType();
-
-  if (confidence_threshold)
-    request.set_header("decoder.confidenceThreshold",
-                       std::to_string(confidence_threshold));
-  if (max_sentences)
-    request.set_header("decoder.maxSentences", std::to_string(max_sentences));
-
-  if (no_input_timeout_enabled) {
-    request.set_header("noInputTimeout.enabled",
-                       std::to_string(no_input_timeout_enabled));
-    if (no_input_timeout_milliseconds)
-      request.set_header("noInputTimeout.value",
-                         std::to_string(no_input_timeout_milliseconds));
-  }
-
-  if (recog_timeout_enabled) {
-    request.set_header("recognitionTimeout.enabled",
-                       std::to_string(recog_timeout_enabled));
-    if (recog_timeout_seconds)
-      request.set_header("recognitionTimeout.value",
-                         std::to_string(recog_timeout_seconds));
-  }
-
-  if (infer_age_enabled) {
-    request.set_header("Infer-age-enabled", "true");
-  }
-
-  if (infer_emotion_enabled) {
-    request.set_header("Infer-emotion-enabled", "true");
-  }
-
-  if (infer_gender_enabled) {
-    request.set_header("Infer-gender-enabled", "true");
-  }
-
-  if (head_margin_milliseconds)
-    request.set_header("endpointer.headMargin",
-                       std::to_string(head_margin_milliseconds));
-
-  if (tail_margin_milliseconds)
-    request.set_header("endpointer.tailMargin",
-                       std::to_string(tail_margin_milliseconds));
-
-  if (wait_end_milliseconds)
-    request.set_header("endpointer.waitEnd",
-                       std::to_string(wait_end_milliseconds));
-
-  if (continuous_mode) {
-    request.set_header("decoder.continuousMode", "true");
-  }
-  if (max_segment_duration)
-    request.set_header("endpointer.maxSegmentDuration",
-                       std::to_string(max_segment_duration));
-
-  if (start_input_timers) {
-    request.set_header("decoder.startInputTimers",
-                       std::to_string(start_input_timers));
-  }
-
-  if (endpointer_level_mode) {
-    request.set_header("endpointer.levelMode",
-                       std::to_string(endpointer_level_mode));
-    if (endpointer_level_mode == 1 && endpointer_auto_level_len)
-      request.set_header("endpointer.autoLevelLen",
-                         std::to_string(endpointer_auto_level_len));
-    if (endpointer_level_mode == 2 && endpointer_level_threshold)
-      request.set_header("endpointer.levelThreshold",
-                         std::to_string(endpointer_level_threshold));
-  }
-
-  if (verify_buffer_utterance) {
-    request.set_header("Ver-Buffer-Utterance", "true");
-  }
-
-  if (!account_tag.empty()) {
-      request.set_header("licenseManager.accountTag", account_tag);
-  }
-
-  if (!channel_identifier.empty()) {
-      request.set_header("Channel-Identifier", channel_identifier);
-  }
-
-  if (!media_type.empty()) {
-      request.set_header("Media-Type", media_type);
+  // Serialized once per config, only the headers the session doesn't have
+  // yet are sent
+  for (const auto &header : impl.session_params_.pending()) {
+    request.set_header(header.first, header.second);
   }
 
   std::string raw_message = request.raw();
@@ -156,37 +53,41 @@ void ASRSendMessage::setParameters(SpeechRecognizer::Impl &impl) {
 }
 
 void ASRSendMessage::startRecognition(SpeechRecognizer::Impl &impl) {
-  std::string lm_uri, grammar_body, extra;
-  std::string content_type;
+  std::shared_ptr<const std::string> raw_message =
+      ASRMessageRequest::startRecognition(*impl.lm_);
 
-  lm_uri = impl.lm_->getUri();
-  grammar_body = impl.lm_->getGrammarBody();
+  // grammars may be large, only their headers are logged
+  if (impl.lm_->getGrammarBody().empty()) {
+    impl.logger_.write(websocketpp::log::elevel::info,
+                       "[SEND] " + *raw_message);
+  } else {
+    impl.logger_.write(websocketpp::log::elevel::info,
+                       "[SEND] " + raw_message->substr(
+                           0, raw_message->find(hdr_delimiter)));
+  }
 
-  ASRMessageRequest request(Method::StartRecognition);
-  request.set_header("Accept", "application/json");
+  // the response time of START_RECOGNITION is the round trip sample used to
+  // size the audio frames
+  impl.start_sent_ = std::chrono::steady_clock::now();
+  impl.sendMessage(*raw_message);
+}
 
-  // if lm property uri and grammar body was not set, throw an error
-  if (!lm_uri.empty()) {
-    extra = lm_uri;
-    content_type = "text/uri-list";
-  } else if (!grammar_body.empty()) {
-    extra = grammar_body;
-    content_type = "application/srgs";
+void ASRSendMessage::releaseSession(SpeechRecognizer::Impl &impl) {
+  ASRMessageRequest request(Method::ReleaseSession);
+  std::string raw_message = request.raw();
 
-    // only one grammar is allowed, so the id is fixed by now
-    request.set_header("Content-ID", "gram");
-  } else {
-    throw RecognitionException(RecognitionError::Code::FAILURE,
-        std::string("lm uri and grammar body is emprty"));
-  }
+  impl.logger_.write(websocketpp::log::elevel::info,
+                            "[SEND] " + raw_message);
 
-  request.set_header("Content-Type", content_type);
-  request.set_extra(extra);
-  request.set_header("Content-Length", std::to_string(extra.size()));
+  impl.sendMessage(raw_message);
+}
 
+void ASRSendMessage::startInputTimers(SpeechRecognizer::Impl &impl) {
+  ASRMessageRequest request(Method::StartInputTimers);
   std::string raw_message = request.raw();
 
-  impl.logger_.write(websocketpp::log::elevel::info, "[SEND] " + raw_message);
+  impl.logger_.write(websocketpp::log::elevel::info,
+                            "[SEND] " + raw_message);
 
   impl.sendMessage(raw_message);
 }
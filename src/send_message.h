@@ -29,6 +29,10 @@ class ASRSendMessage {
   void setParameters(SpeechRecognizer::Impl& impl);
 
   void startRecognition(SpeechRecognizer::Impl& impl);
+
+  void releaseSession(SpeechRecognizer::Impl& impl);
+
+  void startInputTimers(SpeechRecognizer::Impl& impl);
 };
 
 #endif  // SRC_SENDMESSAGE_H_
@@ -0,0 +1,171 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#include "src/session_parameters.h"
+
+#include <utility>
+
+namespace {
+
+// Value that takes a boolean header back to its default. Headers serialized
+// with std::to_string(bool) use its format. The server starts the input
+// timers by default, so deferring them is the value kept by the session.
+const char* offValue(const std::string& key) {
+  static const std::map<std::string, const char*> off_values = {
+      {"Infer-age-enabled", "false"},
+      {"Infer-emotion-enabled", "false"},
+      {"Infer-gender-enabled", "false"},
+      {"Ver-Buffer-Utterance", "false"},
+      {"decoder.continuousMode", "false"},
+      {"decoder.startInputTimers", "1"},
+      {"noInputTimeout.enabled", "0"},
+      {"recognitionTimeout.enabled", "0"},
+  };
+  auto it = off_values.find(key);
+  return it == off_values.end() ? nullptr : it->second;
+}
+
+}  // namespace
+
+std::shared_ptr<const SessionParameters::Headers> SessionParameters::defaults(
+    bool defer_input_timers) {
+  std::shared_ptr<Headers> headers = std::make_shared<Headers>();
+  if (defer_input_timers)
+    (*headers)["decoder.startInputTimers"] = std::to_string(false);
+  return headers;
+}
+
+std::shared_ptr<const SessionParameters::Headers> SessionParameters::serialize(
+    const RecognitionConfig& config, bool defer_input_timers) {
+  std::shared_ptr<Headers> headers = std::make_shared<Headers>();
+  Headers& h = *headers;
+
+  unsigned int confidence_threshold = config.confidenceThreshold();
+  unsigned int max_sentences = config.maxSentences();
+  unsigned int no_input_timeout_milliseconds =
+      config.noInputTimeoutMilliseconds();
+  unsigned int recog_timeout_seconds = config.recognitionTimeoutSeconds();
+  bool no_input_timeout_enabled = config.noInputTimeoutEnabled();
+  bool recog_timeout_enabled = config.recognitionTimeoutEnabled();
+  unsigned int endpointer_level_mode = config.endpointerLevelMode();
+
+  if (confidence_threshold)
+    h["decoder.confidenceThreshold"] = std::to_string(confidence_threshold);
+  if (max_sentences)
+    h["decoder.maxSentences"] = std::to_string(max_sentences);
+
+  if (no_input_timeout_enabled) {
+    h["noInputTimeout.enabled"] = std::to_string(no_input_timeout_enabled);
+    if (no_input_timeout_milliseconds)
+      h["noInputTimeout.value"] =
+          std::to_string(no_input_timeout_milliseconds);
+  }
+
+  if (recog_timeout_enabled) {
+    h["recognitionTimeout.enabled"] = std::to_string(recog_timeout_enabled);
+    if (recog_timeout_seconds)
+      h["recognitionTimeout.value"] = std::to_string(recog_timeout_seconds);
+  }
+
+  if (config.inferAgeEnabled()) h["Infer-age-enabled"] = "true";
+  if (config.inferEmotionEnabled()) h["Infer-emotion-enabled"] = "true";
+  if (config.inferGenderEnabled()) h["Infer-gender-enabled"] = "true";
+
+  if (config.headMarginMilliseconds())
+    h["endpointer.headMargin"] =
+        std::to_string(config.headMarginMilliseconds());
+  if (config.tailMarginMilliseconds())
+    h["endpointer.tailMargin"] =
+        std::to_string(config.tailMarginMilliseconds());
+  if (config.waitEndMilliseconds())
+    h["endpointer.waitEnd"] = std::to_string(config.waitEndMilliseconds());
+
+  if (config.continuousMode()) h["decoder.continuousMode"] = "true";
+  if (config.maxSegmentDuration())
+    h["endpointer.maxSegmentDuration"] =
+        std::to_string(config.maxSegmentDuration());
+
+  if (defer_input_timers)
+    h["decoder.startInputTimers"] = std::to_string(false);
+  else if (config.startInputTimers())
+    h["decoder.startInputTimers"] = std::to_string(config.startInputTimers());
+
+  if (endpointer_level_mode) {
+    h["endpointer.levelMode"] = std::to_string(endpointer_level_mode);
+    if (endpointer_level_mode == 1 && config.endpointerAutoLevelLen())
+      h["endpointer.autoLevelLen"] =
+          std::to_string(config.endpointerAutoLevelLen());
+    if (endpointer_level_mode == 2 && config.endpointerLevelThreshold())
+      h["endpointer.levelThreshold"] =
+          std::to_string(config.endpointerLevelThreshold());
+  }
+
+  if (config.verifyBufferUtterance()) h["Ver-Buffer-Utterance"] = "true";
+
+  if (!config.accountTag().empty())
+    h["licenseManager.accountTag"] = config.accountTag();
+  if (!config.channelIdentifier().empty())
+    h["Channel-Identifier"] = config.channelIdentifier();
+  if (!config.mediaType().empty())
+    h["Media-Type"] = config.mediaType();
+
+  return headers;
+}
+
+void SessionParameters::reset() {
+  current_.clear();
+  pending_.clear();
+  acknowledged_ = false;
+}
+
+bool SessionParameters::prepare(const Headers& desired) {
+  pending_.clear();
+  for (const auto& header : desired) {
+    auto it = current_.find(header.first);
+    if (it == current_.end()) {
+      // a boolean at its default is not kept once acknowledged, the session
+      // already has it. A new session gets the whole config, as configured.
+      const char* off = offValue(header.first);
+      if (!acknowledged_ || !off || header.second != off)
+        pending_.insert(header);
+    } else if (it->second != header.second) {
+      pending_.insert(header);
+    }
+  }
+  for (const auto& header : current_) {
+    if (desired.count(header.first)) continue;
+    const char* off = offValue(header.first);
+    if (!off) {
+      pending_.clear();
+      return false;
+    }
+    pending_[header.first] = off;
+  }
+  return true;
+}
+
+void SessionParameters::acknowledge() {
+  for (auto& header : pending_) {
+    const char* off = offValue(header.first);
+    if (off && header.second == off)
+      current_.erase(header.first);
+    else
+      current_[header.first] = std::move(header.second);
+  }
+  pending_.clear();
+  acknowledged_ = true;
+}
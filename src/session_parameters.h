@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#ifndef SRC_SESSION_PARAMETERS_H_
+#define SRC_SESSION_PARAMETERS_H_
+
+#include <cpqd/asr-client/recognition_config.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+/// Recognition parameters of a server session
+/**
+ * A session keeps the parameters of every SET_PARAMETERS sent on it, so a
+ * recognition only needs to send the headers whose value differs from the
+ * ones acknowledged by the server, if any.
+ *
+ * Headers are the serialized form of a RecognitionConfig, computed once per
+ * config with serialize(). Fields left at their defaults are not serialized;
+ * taking a boolean back to its default is done by sending its default value,
+ * other fields can only be reset by creating a new session.
+ */
+class SessionParameters {
+ public:
+  typedef std::map<std::string, std::string> Headers;
+
+  /// Serialize a config into SET_PARAMETERS headers
+  /**
+   * @param [in] defer_input_timers Keep the input timers stopped until a
+   *   START_INPUT_TIMERS message, whatever the config says.
+   */
+  static std::shared_ptr<const Headers> serialize(
+      const RecognitionConfig& config, bool defer_input_timers = false);
+
+  /// Headers of a recognizer without config, the server defaults
+  static std::shared_ptr<const Headers> defaults(bool defer_input_timers);
+
+  /// Forget the parameters, a new session has the server defaults
+  void reset();
+
+  /// Compute the headers that move the session to the desired parameters
+  /**
+   * @return false if the session can't reach them, some parameter has to
+   *   be reset to a server default. A new session is needed.
+   */
+  bool prepare(const Headers& desired);
+
+  /// Headers computed by the last prepare(), empty if none must be sent
+  const Headers& pending() const { return pending_; }
+
+  /// The server accepted the pending headers
+  void acknowledge();
+
+  /// Parameters acknowledged by the server
+  const Headers& current() const { return current_; }
+
+ private:
+  Headers current_;
+  Headers pending_;
+  // some SET_PARAMETERS went through, the booleans missing from current_
+  // are known to be at their defaults
+  bool acknowledged_ = false;
+};
+
+#endif  // SRC_SESSION_PARAMETERS_H_
@@ -16,6 +16,7 @@
 
 #include <cpqd/asr-client/speech_recog.h>
 
+#include <algorithm>
 #include <mutex>
 #include <vector>
 
@@ -38,9 +39,52 @@ void SpeechRecognizer::resetImpl() {
   } else
     impl_->config_ = nullptr;
 
+  // The recognizer config never changes, it is serialized once
+  impl_->defer_input_timers_ = properties_->defer_input_timers_;
+  impl_->config_headers_ =
+      impl_->config_ ? SessionParameters::serialize(*impl_->config_,
+                                                    impl_->defer_input_timers_)
+                     : SessionParameters::defaults(impl_->defer_input_timers_);
+
   if (!properties_->listener_.empty())
     impl_->listener_ = std::move(properties_->listener_);
 
+  // Subtrees of the result body the application opted out of are skipped
+  // by the decoder
+  ASRResultDecoder::Options decoder_options;
+  decoder_options.words = properties_->decode_words_;
+  decoder_options.interpretations = properties_->decode_interpretations_;
+  impl_->decoder_ = ASRResultDecoder(decoder_options);
+  impl_->raw_results_ = properties_->raw_results_;
+  impl_->completion_queue_ = properties_->completion_queue_;
+  impl_->completion_id_ = properties_->completion_id_;
+  impl_->result_.reset(new ResultQueue(properties_->result_queue_size_,
+                                       properties_->result_overflow_));
+  impl_->outbound_.setAudioHighWater(properties_->send_high_water_mark_);
+  impl_->endpoints_ = properties_->endpoints_;
+  impl_->priority_ = properties_->priority_;
+  impl_->tenant_ = properties_->tenant_;
+  impl_->channel_ = impl_->config_ ? impl_->config_->channelIdentifier() : "";
+  // a hedge sends the same audio as a replay
+  impl_->replay_.configure(std::max(properties_->replay_window_bytes_,
+                                    properties_->hedge_window_bytes_));
+  impl_->hedging_ = properties_->hedge_window_bytes_ > 0;
+  impl_->replay_max_attempts_ = properties_->replay_attempts_;
+  impl_->ping_interval_ =
+      std::chrono::milliseconds(properties_->ping_interval_ms_);
+  impl_->pong_timeout_ =
+      std::chrono::milliseconds(properties_->pong_timeout_ms_);
+  impl_->chunks_.configure(properties_->audio_pacing_,
+                           properties_->audio_chunk_min_ms_,
+                           properties_->audio_chunk_max_ms_);
+  impl_->partials_.configure(
+      std::chrono::milliseconds(properties_->partial_interval_ms_),
+      properties_->partial_min_text_delta_);
+
+  // Listeners run on the application executor, inline when none was given
+  impl_->callbacks_.reset(
+      new CallbackStrand(properties_->callback_executor_));
+
   impl_->out_.open((properties_->log_path_).c_str(), std::fstream::app);
   impl_->logger_.set_ostream(&impl_->out_);
   impl_->logger_.set_channels(websocketpp::log::alevel::all);
@@ -76,10 +120,16 @@ void SpeechRecognizer::cancelRecognition() {
   impl_->logger_.write(websocketpp::log::elevel::info,
                 "[SEND] " + raw_message);
 
+  // Audio not written yet is dropped, the cancel request goes out ahead of
+  // it and no audio can follow it
+  impl_->cancel_start_ = std::chrono::steady_clock::now();
+  impl_->cancel_pending_ = true;
+  impl_->prepared_ = false;
+  impl_->outbound_.discardAudio();
   impl_->sendMessage(raw_message);
   
   if(impl_->sendAudioMessage_thread_.joinable()){
-    impl_->sendAudioMessage_terminate_ = true;
+    impl_->stopAudioThread();
     impl_->sendAudioMessage_thread_.join();
   }
 
@@ -91,46 +141,185 @@ void SpeechRecognizer::cancelRecognition() {
   }
 }
 
+void SpeechRecognizer::releaseSession() {
+  if (!impl_->open_ ||
+      impl_->session_status_ == SpeechRecognizer::Impl::SessionStatus::kNone)
+    return;
+  if (impl_->recognizing_) {
+    throw RecognitionException(RecognitionError::Code::ACTIVE_RECOGNITION,
+      "There is a recognition already running in this recognizier!"
+    );
+  }
+  impl_->terminateSendMessageThread();
+  impl_->eptr_ = nullptr;
+
+  ASRSendMessage send_msg_;
+  send_msg_.releaseSession(*impl_);
+
+  std::unique_lock<std::mutex> lk(impl_->lock_);
+  if (!impl_->cv_.wait_for(
+          lk, std::chrono::seconds(properties_->max_wait_seconds_), [this]() {
+            return impl_->session_status_ ==
+                       SpeechRecognizer::Impl::SessionStatus::kNone ||
+                   impl_->eptr_;
+          })) {
+    throw RecognitionException(RecognitionError::Code::FAILURE,
+                               "Timeout on release session");
+  }
+  if (impl_->eptr_) std::rethrow_exception(impl_->eptr_);
+}
+
 void SpeechRecognizer::recognize(
     const std::shared_ptr<AudioSource> &audio_src,
     std::unique_ptr<LanguageModelList> lm) {
+  recognize(audio_src, std::shared_ptr<const LanguageModelList>(std::move(lm)),
+            nullptr);
+}
+
+void SpeechRecognizer::recognize(
+    const std::shared_ptr<AudioSource> &audio_src,
+    std::shared_ptr<const LanguageModelList> lm,
+    std::shared_ptr<const RecognitionConfig> config) {
+  beginRecognition(audio_src, std::move(lm), std::move(config));
+}
+
+void SpeechRecognizer::prepareRecognition(
+    std::shared_ptr<const LanguageModelList> lm,
+    std::shared_ptr<const RecognitionConfig> config) {
+  beginRecognition(nullptr, std::move(lm), std::move(config));
+}
+
+bool SpeechRecognizer::isArmed() const {
+  std::unique_lock<std::mutex> lk(impl_->lock_);
+  return impl_->prepared_ && impl_->armed_;
+}
+
+void SpeechRecognizer::recognize(
+    const std::shared_ptr<AudioSource> &audio_src) {
+  if (!impl_->prepared_.exchange(false)) {
+    throw RecognitionException(RecognitionError::Code::FAILURE,
+      "There is no prepared recognition in this recognizer!"
+    );
+  }
+  // the wait for results starts with the audio
+  start_ = std::chrono::system_clock::now();
+  impl_->attachAudio(audio_src);
+}
+
+void SpeechRecognizer::startInputTimers() {
+  if (!impl_->recognizing_) {
+    throw RecognitionException(RecognitionError::Code::FAILURE,
+      "There is no recognition running in this recognizer!"
+    );
+  }
+  impl_->requestInputTimers();
+}
+
+void SpeechRecognizer::beginRecognition(
+    const std::shared_ptr<AudioSource> &audio_src,
+    std::shared_ptr<const LanguageModelList> lm,
+    std::shared_ptr<const RecognitionConfig> config) {
   if(impl_->recognizing_){
     throw RecognitionException(RecognitionError::Code::ACTIVE_RECOGNITION,
       "There is a recognition already running in this recognizier!"
     );
   }
+  // The audio thread of the previous recognition is still around when its
+  // outcome was taken from a completion queue
+  impl_->terminateSendMessageThread();
+  impl_->stopReplay();
+  impl_->stopHedge();
+  impl_->audio_end_us_ = 0;
+  impl_->result_latency_us_ = 0;
+  impl_->replay_.reset();
+  impl_->replay_attempts_ = 0;
+  impl_->replay_pending_ = false;
+
   start_ = std::chrono::system_clock::now();
   impl_->recognizing_ = true;
   impl_->eptr_ = nullptr;
-  impl_->result_.clear();
+  impl_->result_->clear();
+  impl_->partials_.reset();
+  impl_->prepared_ = audio_src == nullptr;
+  impl_->armed_ = false;
 
   impl_->audio_src_ = audio_src;
+  if (audio_src) impl_->chunks_.setFormat(audio_src->getAudioFormat());
   impl_->lm_ = std::move(lm);
+  impl_->recog_params_ =
+      config ? impl_->parametersOf(config) : impl_->config_headers_;
+
+  // A connection the keepalive found dead is replaced
+  if (impl_->open_ &&
+      impl_->status_ != SpeechRecognizer::Impl::Status::kOpen) {
+    impl_->close();
+  }
 
   // Only try to connect if connection is closed. This will be true
   // if connect_on_recognize_ is true or if auto_close is true and we already
   // performed one recognition
   if(!impl_->open_){
-    impl_->open(properties_->url_, properties_->user_, properties_->passwd_);
+    try {
+      impl_->open(properties_->url_, properties_->user_, properties_->passwd_);
+    } catch (...) {
+      // reported by the exception only, not by the completion queue too
+      impl_->recognizing_ = false;
+      throw;
+    }
   }
 
+  // Shed load instead of queueing for long on a saturated server
+  if (impl_->endpoints_) {
+    EndpointGroup::Admission admission;
+    admission.priority_ = impl_->priority_;
+    admission.tenant_ = impl_->tenant_;
+    if (admission.tenant_.empty())
+      admission.tenant_ = config ? config->accountTag()
+                          : impl_->config_ ? impl_->config_->accountTag()
+                                           : "";
+    if (!impl_->endpoints_->admit(impl_->endpoint_, admission)) {
+      ++impl_->admission_rejections_;
+      impl_->recognizing_ = false;
+      throw RecognitionException(RecognitionError::Code::OVERLOADED,
+                                 "Concurrency limit reached on server " +
+                                     impl_->url_);
+    }
+    impl_->admitted_endpoint_ = impl_->endpoint_;
+    impl_->admitted_ = true;
+  }
+  // from now on the outcome goes to the completion queue
+  impl_->completion_pending_ = impl_->completion_queue_ != nullptr;
+
   ASRSendMessage send_msg_;
   if (impl_->session_status_ == SpeechRecognizer::Impl::SessionStatus::kNone) {
     send_msg_.createSession(*impl_);
     return;
   }
-  send_msg_.startRecognition(*impl_);
+
+  // The session keeps the parameters of the previous recognitions
+  if (!impl_->session_params_.prepare(*impl_->recog_params_)) {
+    // some parameter must go back to the server default, which only a new
+    // session has
+    send_msg_.releaseSession(*impl_);
+    send_msg_.createSession(*impl_);
+    return;
+  }
+  if (impl_->session_params_.pending().empty()) {
+    send_msg_.startRecognition(*impl_);
+    return;
+  }
+  send_msg_.setParameters(*impl_);
 }
 
 std::vector<RecognitionResult> SpeechRecognizer::waitRecognitionResult() {
-  if (!impl_->open_){
-    auto ret = impl_->result_;
-    impl_->result_.clear();
+  // closed between two attempts of a reconnection, the recognition goes on
+  if (!impl_->open_ && !impl_->replay_active_){
+    auto ret = impl_->takeResults();
     if (impl_->eptr_)
       std::rethrow_exception(impl_->eptr_);
     // Close after successful recognition
     if(properties_->auto_close_ && impl_->open_){
-      resetImpl();
+      impl_->reset();
     }
     return ret; 
   }
@@ -144,22 +333,26 @@ std::vector<RecognitionResult> SpeechRecognizer::waitRecognitionResult() {
   ) - duration;
 
   if (impl_->cv_.wait_for(lk, time_waiting, [this]() {
-        return impl_->result_.size() > 0
+        return !impl_->result_->empty()
             || impl_->eptr_
             || !impl_->recognizing_;
       })) {
+    lk.unlock();
     impl_->terminateSendMessageThread();
-    auto ret = impl_->result_;
-    impl_->result_.clear();
+    auto ret = impl_->takeResults();
     if (impl_->eptr_){
       std::rethrow_exception(impl_->eptr_);
     }
-    // Close after successful recognition
+    // Close after successful recognition, the I/O thread may need the lock
+    // to finish
     if(properties_->auto_close_ && impl_->open_){
-      resetImpl();
+      impl_->reset();
     }
     return ret; 
   } else {
+    // a server that doesn't answer is one too many recognitions
+    lk.unlock();
+    impl_->releaseAdmission(true);
     throw RecognitionException(
       RecognitionError::Code::FAILURE,
       "Timeout on speech recog"                          
@@ -168,6 +361,86 @@ std::vector<RecognitionResult> SpeechRecognizer::waitRecognitionResult() {
   return {};
 }
 
+bool SpeechRecognizer::nextResult(RecognitionResult &result,
+                                  std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  bool timed_out = false;
+  bool invalid = false;
+  {
+    std::unique_lock<std::mutex> lk(impl_->lock_);
+    while (true) {
+      // Read before the queue: the last result is pushed before the
+      // recognition is flagged as finished
+      bool finished = !impl_->recognizing_;
+      if (impl_->result_->pop(result))
+        return true;
+      // reported without the lock, ending the recognition takes it
+      if (impl_->result_->takeInvalid() > 0 && !impl_->eptr_) {
+        invalid = true;
+        break;
+      }
+      if (impl_->eptr_)
+        std::rethrow_exception(impl_->eptr_);
+      if (finished || timed_out)
+        break;
+      timed_out = impl_->cv_.wait_until(lk, deadline) ==
+          std::cv_status::timeout;
+    }
+  }
+
+  if (invalid) {
+    impl_->recognitionError(RecognitionError::Code::FAILURE,
+                            "Invalid recognition result body");
+    std::rethrow_exception(impl_->eptr_);
+  }
+
+  if (timed_out) {
+    throw RecognitionException(
+      RecognitionError::Code::FAILURE,
+      "Timeout on speech recog"
+    );
+  }
+
+  impl_->terminateSendMessageThread();
+  // Close after successful recognition
+  if(properties_->auto_close_ && impl_->open_){
+    impl_->reset();
+  }
+  return false;
+}
+
 bool SpeechRecognizer::isOpen() {
   return impl_->open_;
 }
+
+RecognizerMetrics SpeechRecognizer::getMetrics() const {
+  RecognizerMetrics metrics;
+  impl_->callbacks_->metrics(metrics);
+  impl_->partials_.metrics(metrics);
+  impl_->result_->metrics(metrics);
+  impl_->outbound_.metrics(metrics);
+  metrics.connections_ = impl_->connections_;
+  metrics.connections_lost_ = impl_->connections_lost_;
+  metrics.pings_ = impl_->pings_;
+  metrics.replays_ = impl_->replays_;
+  metrics.replayed_bytes_ = impl_->replayed_bytes_;
+  metrics.hedge_eligible_ = impl_->hedge_eligible_;
+  metrics.hedges_ = impl_->hedges_;
+  metrics.hedge_wins_ = impl_->hedge_wins_;
+  metrics.admission_rejections_ = impl_->admission_rejections_;
+  metrics.uplink_throttled_time_ =
+      std::chrono::microseconds(impl_->uplink_throttled_us_);
+  metrics.tls_handshakes_ = impl_->tls_handshakes_;
+  metrics.tls_resumed_handshakes_ = impl_->tls_resumed_;
+  metrics.tls_handshake_time_ =
+      std::chrono::microseconds(impl_->tls_handshake_time_us_);
+  metrics.tls_handshake_max_time_ =
+      std::chrono::microseconds(impl_->tls_handshake_max_time_us_);
+  metrics.sessions_created_ = impl_->sessions_;
+  metrics.cancels_ = impl_->cancels_;
+  metrics.cancel_latency_ =
+      std::chrono::microseconds(impl_->cancel_latency_us_);
+  metrics.cancel_max_latency_ =
+      std::chrono::microseconds(impl_->cancel_max_latency_us_);
+  return metrics;
+}
@@ -45,6 +45,27 @@ SpeechRecognizer::Builder &SpeechRecognizer::Builder::serverUrl(
   return *this;
 }
 
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::endpoints(
+    std::shared_ptr<EndpointGroup> group) {
+  if (!group)
+    throw std::invalid_argument("Empty endpoint group");
+
+  properties_->endpoints_ = std::move(group);
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::priority(
+    RecognitionPriority priority) {
+  properties_->priority_ = priority;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::tenant(
+    const std::string &tenant) {
+  properties_->tenant_ = tenant;
+  return *this;
+}
+
 SpeechRecognizer::Builder &SpeechRecognizer::Builder::credentials(
     const std::string &user, const std::string &passwd) {
   properties_->user_ = user;
@@ -106,6 +127,116 @@ SpeechRecognizer::Builder &SpeechRecognizer::Builder::logPath(
   return *this;
 }
 
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::decodeWords(
+  bool value) {
+  properties_->decode_words_ = value;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::decodeInterpretations(
+  bool value) {
+  properties_->decode_interpretations_ = value;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::rawResults(
+  bool value) {
+  properties_->raw_results_ = value;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::callbackExecutor(
+  std::shared_ptr<CallbackExecutor> executor) {
+  properties_->callback_executor_ = std::move(executor);
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::partialResultInterval(
+  unsigned int milliseconds) {
+  properties_->partial_interval_ms_ = milliseconds;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::partialMinTextDelta(
+  unsigned int characters) {
+  properties_->partial_min_text_delta_ = characters;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::resultQueueSize(
+  unsigned int value) {
+  if (value == 0)
+    throw std::invalid_argument("Result queue size must be positive");
+  properties_->result_queue_size_ = value;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::resultQueueOverflow(
+  ResultOverflow value) {
+  properties_->result_overflow_ = value;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::completionQueue(
+  std::shared_ptr<CompletionQueue> queue, uint64_t id) {
+  properties_->completion_queue_ = std::move(queue);
+  properties_->completion_id_ = id;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::sendHighWaterMark(
+  size_t bytes) {
+  if (bytes == 0)
+    throw std::invalid_argument("Send high water mark must be positive");
+  properties_->send_high_water_mark_ = bytes;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::audioChunkDuration(
+  unsigned int min_ms, unsigned int max_ms) {
+  if (min_ms == 0 || min_ms > max_ms)
+    throw std::invalid_argument("Invalid audio chunk duration");
+  properties_->audio_chunk_min_ms_ = min_ms;
+  properties_->audio_chunk_max_ms_ = max_ms;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::audioPacing(
+  AudioPacing value) {
+  properties_->audio_pacing_ = value;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::deferInputTimers(
+  bool value) {
+  properties_->defer_input_timers_ = value;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::keepAlive(
+  unsigned int ping_interval_ms, unsigned int pong_timeout_ms) {
+  if (ping_interval_ms > 0 && pong_timeout_ms == 0)
+    throw std::invalid_argument("Pong timeout must be positive");
+  properties_->ping_interval_ms_ = ping_interval_ms;
+  properties_->pong_timeout_ms_ = pong_timeout_ms;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::replayOnConnectionLoss(
+  unsigned int max_attempts, size_t window_bytes) {
+  if (max_attempts > 0 && window_bytes == 0)
+    throw std::invalid_argument("Replay window must be positive");
+  properties_->replay_attempts_ = max_attempts;
+  properties_->replay_window_bytes_ = max_attempts > 0 ? window_bytes : 0;
+  return *this;
+}
+
+SpeechRecognizer::Builder &SpeechRecognizer::Builder::hedgeRecognitions(
+  size_t window_bytes) {
+  properties_->hedge_window_bytes_ = window_bytes;
+  return *this;
+}
+
 std::unique_ptr<SpeechRecognizer> SpeechRecognizer::Builder::build() {
   SpeechRecognizer *tmp = new SpeechRecognizer(std::move(properties_));
   return std::unique_ptr<SpeechRecognizer>(tmp);
@@ -16,11 +16,15 @@
 
 #include "src/speech_recog_impl.h"
 
+#include <algorithm>
 #include <atomic>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
 
+#include <cpqd/asr-client/buffer_audio_source.h>
 #include <cpqd/asr-client/recognition_exception.h>
 #include <websocketpp/uri.hpp>
 
@@ -28,13 +32,22 @@
 #include "src/asr_message_response.h"
 #include "src/process_msg.h"
 #include "src/process_result.h"
+#include "src/send_message.h"
+#include "src/tls_session_cache.h"
 #include "src/websocket_client.h"
 
-SpeechRecognizer::Impl::Impl() {
+SpeechRecognizer::Impl::Impl()
+    : result_(new ResultQueue()),
+      outbound_([this](const std::string& raw) { writeMessage(raw); },
+                [this]() { return bufferedAmount(); }),
+      callbacks_(new CallbackStrand(CallbackExecutor::inlineExecutor())) {
 }
 
 SpeechRecognizer::Impl::~Impl() {
+  stopReplay();
+  stopHedge();
   if(open_) close();
+  releaseAdmission(false);
 }
 
 void SpeechRecognizer::Impl::open(const std::string& url,
@@ -42,20 +55,66 @@ void SpeechRecognizer::Impl::open(const std::string& url,
                                   std::string pass) {
   if (open_) return;
 
+  if (!connect(url, user, pass)) {
+    auto code = RecognitionError::Code::CONNECTION_FAILURE;
+    std::string msg("Failure on connecting to server " + url_);
+    if (!connect_error_.empty()) msg += ": " + connect_error_;
+    notifyListeners([code, msg](RecognitionListener& listener) {
+      RecognitionError error(code, msg);
+      listener.onError(error);
+    });
+    // Connection error shouldn't be ignorable, as pretty much nothing can be
+    // done with the SpeechRecognition instance if a connection isn't
+    // estabilished
+    throw RecognitionException(code, msg);
+  }
+}
+
+bool SpeechRecognizer::Impl::connect(const std::string& url,
+                                     const std::string& user,
+                                     const std::string& pass) {
   using std::placeholders::_1;
   using std::placeholders::_2;
 
-  websocketpp::uri uri(url);
+  // a group picks another server on every connection
+  std::string target = url;
+  if (endpoints_) {
+    endpoint_ = endpoints_->acquire(channel_, avoid_endpoint_);
+    target = endpoints_->url(endpoint_);
+  }
+
+  // kept to reconnect a running recognition
+  url_ = target;
+  user_ = user;
+  pass_ = pass;
 
+  websocketpp::uri uri(target);
+  auto setup_start = std::chrono::steady_clock::now();
+
+  status_ = Status::kConnecting;
+  connect_error_.clear();
+  ++connections_;
   if (uri.get_secure()) {
     secure_ = true;
-    client_tls_.set_tls_init_handler(
-          std::bind(&SpeechRecognizer::Impl::onTlsInit, this, _1)
-          );
-    WsClient<Client_tls>::init(this, &client_tls_, url, user, pass);
+    tls_host_ = uri.get_host() + ":" + std::to_string(uri.get_port());
+    if (!client_tls_ready_) {
+      client_tls_.set_tls_init_handler(
+            std::bind(&SpeechRecognizer::Impl::onTlsInit, this, _1)
+            );
+      client_tls_.set_socket_init_handler(
+            std::bind(&SpeechRecognizer::Impl::onTlsSocketInit, this, _1, _2)
+            );
+      WsClient<Client_tls>::init(this, &client_tls_);
+      client_tls_ready_ = true;
+    }
+    WsClient<Client_tls>::connect(this, &client_tls_, target, user, pass);
   } else {
     secure_ = false;
-    WsClient<Client>::init(this, &client_, url);
+    if (!client_ready_) {
+      WsClient<Client>::init(this, &client_);
+      client_ready_ = true;
+    }
+    WsClient<Client>::connect(this, &client_, target);
   }
   {
     std::unique_lock<std::mutex> lk(lock_);
@@ -66,25 +125,36 @@ void SpeechRecognizer::Impl::open(const std::string& url,
     );
   }
   if (status_ != SpeechRecognizer::Impl::Status::kOpen) {
-    auto code = RecognitionError::Code::CONNECTION_FAILURE;
-    std::string msg("Failure on connecting to server " + url);
-    RecognitionError error(code, msg);
-    for (std::unique_ptr<RecognitionListener>& listener : listener_)
-      listener->onError(error);
-    // Connection error shouldn't be ignorable, as pretty much nothing can be
-    // done with the SpeechRecognition instance if a connection isn't
-    // estabilished
-    throw RecognitionException(code, msg);
+    if (endpoints_) {
+      endpoints_->failed(endpoint_);
+      endpoints_->release(endpoint_);
+    }
+    return false;
   }
-  else{
-    open_ = true;
+
+  if (endpoints_) {
+    endpoints_->succeeded(
+        endpoint_, std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - setup_start));
+    endpoint_held_ = true;
   }
+  open_ = true;
+  startKeepAlive();
+  return true;
 }
 
 
+void SpeechRecognizer::Impl::stopAudioThread() {
+  {
+    std::unique_lock<std::mutex> lk(audio_lock_);
+    sendAudioMessage_terminate_ = true;
+  }
+  audio_cv_.notify_all();
+}
+
 void SpeechRecognizer::Impl::terminateSendMessageThread(){
   if(sendAudioMessage_thread_.joinable()){
-    sendAudioMessage_terminate_ = true;
+    stopAudioThread();
     try{
       sendAudioMessage_thread_.join();
     } catch (std::system_error e){
@@ -99,28 +169,629 @@ void SpeechRecognizer::Impl::terminateSendMessageThread(){
 }
 
 
+void SpeechRecognizer::Impl::startAudioThread() {
+  outbound_.resumeAudio();
+  sendAudioMessage_thread_ =
+      std::thread(&ASRProcessResponse::sendAudioMessage, std::ref(*this));
+}
+
+void SpeechRecognizer::Impl::attachAudio(
+    const std::shared_ptr<AudioSource>& audio_src) {
+  chunks_.setFormat(audio_src->getAudioFormat());
+  bool start;
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    audio_src_ = audio_src;
+    start = armed_ && recognizing_;
+  }
+  // otherwise the audio thread is started by the START_RECOGNITION response
+  if (start) startAudioThread();
+}
+
+void SpeechRecognizer::Impl::recognitionStarted() {
+  bool start;
+  bool start_timers;
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    armed_ = true;
+    start = audio_src_ != nullptr && recognizing_;
+    start_timers = input_timers_requested_;
+    input_timers_requested_ = false;
+  }
+  if (start_timers) ASRSendMessage().startInputTimers(*this);
+  // a prepared recognition waits for its audio on standby
+  if (start) startAudioThread();
+}
+
+void SpeechRecognizer::Impl::requestInputTimers() {
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    // sent before START_RECOGNITION the request would be refused
+    if (!armed_) {
+      input_timers_requested_ = true;
+      return;
+    }
+  }
+  ASRSendMessage().startInputTimers(*this);
+}
+
 void SpeechRecognizer::Impl::close() {
   terminateSendMessageThread();
+  stopHedge();
+  closeConnection();
+  releaseAdmission(false);
+}
+
+void SpeechRecognizer::Impl::closeConnection() {
+  stopKeepAlive();
+  // closed on purpose, the close handler must not report a lost connection
+  status_ = Status::kClose;
   if (secure_) {
     WsClient<Client_tls>::close(this, &client_tls_);
   } else {
     WsClient<Client>::close(this, &client_);
   }
+  // the session ends with the connection
+  session_status_ = SessionStatus::kNone;
+  releaseEndpoint();
+}
+
+void SpeechRecognizer::Impl::releaseEndpoint() {
+  // the close handler and close() may both get here
+  if (endpoint_held_.exchange(false)) endpoints_->release(endpoint_);
+}
+
+void SpeechRecognizer::Impl::reset() {
+  stopReplay();
+  if (open_) close();
+  terminateSendMessageThread();
+
+  recognizing_ = false;
+  prepared_ = false;
+  armed_ = false;
+  input_timers_requested_ = false;
+  eptr_ = nullptr;
+  result_->clear();
+  partials_.reset();
+  audio_src_ = nullptr;
+  lm_ = nullptr;
+}
+
+void SpeechRecognizer::Impl::pushResult(ResultQueue::Entry entry) {
+  // the results of a hedge are pushed only once it won
+  if (hedge_owner_) {
+    hedge_owner_->pushResult(std::move(entry));
+    return;
+  }
+  if (!result_->push(std::move(entry))) {
+    recognitionError(RecognitionError::Code::FAILURE,
+                     "Result queue overflow");
+    return;
+  }
+  // Taking the lock orders the push before a waiter that is about to sleep
+  { std::unique_lock<std::mutex> lk(lock_); }
+  cv_.notify_all();
+}
+
+std::vector<RecognitionResult> SpeechRecognizer::Impl::takeResults() {
+  std::vector<RecognitionResult> ret;
+  RecognitionResult res;
+  while (result_->pop(res)) {
+    ret.push_back(std::move(res));
+  }
+  // postCompletion() calls here with the completion already taken, so the
+  // nested finishRecognition() posts nothing
+  if (result_->takeInvalid() > 0 && !eptr_) {
+    recognitionError(RecognitionError::Code::FAILURE,
+                     "Invalid recognition result body");
+  }
+  return ret;
+}
+
+void SpeechRecognizer::Impl::finishRecognition() {
+  // a failure, or a loss to the hedge, means the server was too slow
+  releaseAdmission(eptr_ != nullptr || hedge_ == Hedge::kHedge);
+  recognizing_ = false;
+  cv_.notify_one();
+  postCompletion();
+
+  // the hedge thread waits for either side of a hedged recognition
+  Impl* owner = this;
+  if (hedge_owner_) {
+    owner = hedge_owner_;
+    if (owner->hedge_ == Hedge::kHedge) owner->finishRecognition();
+  }
+  { std::unique_lock<std::mutex> lk(owner->lock_); }
+  owner->hedge_cv_.notify_all();
+}
+
+void SpeechRecognizer::Impl::postCompletion() {
+  if (!completion_queue_ || !completion_pending_.exchange(false)) return;
+
+  CompletionQueue::Event event;
+  event.id_ = completion_id_;
+  event.results_ = takeResults();
+  event.error_ = eptr_;
+  completion_queue_->post(std::move(event));
+}
+
+std::shared_ptr<const SessionParameters::Headers>
+SpeechRecognizer::Impl::parametersOf(
+    const std::shared_ptr<const RecognitionConfig>& config) {
+  // A single entry is enough: an application switching between configs
+  // passes the same few objects again and again
+  if (override_config_.lock() != config) {
+    override_headers_ =
+        SessionParameters::serialize(*config, defer_input_timers_);
+    override_config_ = config;
+  }
+  return override_headers_;
 }
 
 void SpeechRecognizer::Impl::recognitionError(RecognitionError::Code code,
                                               std::string message) {
+  // a hedge that won fails the recognition, otherwise the primary goes on
+  if (hedge_owner_ && hedge_owner_->hedge_ == Hedge::kHedge) {
+    hedge_owner_->recognitionError(code, message);
+    return;
+  }
+
   // invoking callback
-  for (std::unique_ptr<RecognitionListener>& listener : listener_) {
+  notifyListeners([code, message](RecognitionListener& listener) {
     RecognitionError error(code, message);
-    listener->onError(error);
-  }
+    listener.onError(error);
+  });
 
   eptr_ = std::make_exception_ptr(RecognitionException(code, message));
-  cv_.notify_one();
+  // the error ends the recognition, a completion queue user never calls
+  // waitRecognitionResult() to do it
+  stopAudioThread();
+  finishRecognition();
+}
+
+void SpeechRecognizer::Impl::notifyListeners(
+    std::function<void(RecognitionListener&)> callback) {
+  if (hedge_owner_) {
+    if (hedge_owner_->hedge_ == Hedge::kHedge)
+      hedge_owner_->notifyListeners(callback);
+    return;
+  }
+  if (listener_.empty()) return;
+  callbacks_->post([this, callback]() {
+    for (std::unique_ptr<RecognitionListener>& listener : listener_) {
+      callback(*listener);
+    }
+  });
+}
+
+SpeechRecognizer::Impl::Timer SpeechRecognizer::Impl::setTimer(
+    std::chrono::milliseconds delay, std::function<void()> handler) {
+  if (secure_) {
+    return WsClient<Client_tls>::set_timer(&client_tls_, delay.count(),
+                                           handler);
+  } else {
+    return WsClient<Client>::set_timer(&client_, delay.count(), handler);
+  }
+}
+
+void SpeechRecognizer::Impl::received() {
+  last_receive_us_ = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SpeechRecognizer::Impl::pongReceived() {
+  ping_pending_ = false;
+  received();
+}
+
+void SpeechRecognizer::Impl::startKeepAlive() {
+  if (ping_interval_.count() == 0) return;
+  received();
+  ping_pending_ = false;
+
+  // checked twice per pong timeout
+  keepalive_tick_ =
+      std::max(pong_timeout_ / 2, std::chrono::milliseconds(1));
+
+  std::unique_lock<std::mutex> lk(keepalive_lock_);
+  keepalive_running_ = true;
+  keepalive_timer_ = setTimer(keepalive_tick_, [this]() {
+    keepAliveTick();
+  });
+}
+
+void SpeechRecognizer::Impl::stopKeepAlive() {
+  std::unique_lock<std::mutex> lk(keepalive_lock_);
+  keepalive_running_ = false;
+  if (keepalive_timer_) {
+    // a pending timer would keep the I/O thread running
+    websocketpp::lib::asio::error_code err_code;
+    keepalive_timer_->cancel(err_code);
+    keepalive_timer_.reset();
+  }
+}
+
+void SpeechRecognizer::Impl::keepAliveTick() {
+  if (status_ != Status::kOpen) return;
+
+  // A running recognition expects traffic, silence is suspicious sooner
+  std::chrono::milliseconds threshold =
+      recognizing_ ? pong_timeout_ : ping_interval_;
+  int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  int64_t quiet = now - last_receive_us_;
+  // A new ping would restart the pong timeout of the one outstanding
+  if (quiet >= threshold.count() * 1000 && !ping_pending_.exchange(true)) {
+    ++pings_;
+    ping();
+  }
+
+  std::unique_lock<std::mutex> lk(keepalive_lock_);
+  if (keepalive_running_) {
+    keepalive_timer_ = setTimer(keepalive_tick_, [this]() {
+      keepAliveTick();
+    });
+  }
+}
+
+void SpeechRecognizer::Impl::ping() {
+  if (secure_) {
+    WsClient<Client_tls>::ping(this, &client_tls_);
+  } else {
+    WsClient<Client>::ping(this, &client_);
+  }
+}
+
+void SpeechRecognizer::Impl::connectionLost(const std::string& reason) {
+  if (status_.exchange(Status::kFailed) != Status::kOpen) return;
+  ++connections_lost_;
+  logger_.write(websocketpp::log::alevel::app, "Connection lost: " + reason);
+
+  // counts against the server, a group stops picking a failing one
+  if (endpoint_held_) endpoints_->failed(endpoint_);
+  releaseEndpoint();
+
+  // the session died with the connection
+  session_status_ = SessionStatus::kNone;
+  // the audio thread may be waiting for the send queue to drain
+  outbound_.discardAudio();
+  stopAudioThread();
+
+  if (recognizing_ && !startReplay()) {
+    recognitionError(RecognitionError::Code::CONNECTION_FAILURE, reason);
+  }
+  cv_.notify_all();
+}
+
+void SpeechRecognizer::Impl::segmentRecognized(
+    const ASRResultDecoder::Routing& routing) {
+  if (!replay_.enabled()) return;
+  if (routing.has_end_time) {
+    replay_.trim(chunks_.bytes(std::chrono::microseconds(
+        static_cast<int64_t>(routing.end_time * 1000000))));
+  } else {
+    // where the segment ended is unknown, none of its audio is replayed
+    replay_.trim(std::numeric_limits<uint64_t>::max());
+  }
+}
+
+bool SpeechRecognizer::Impl::startReplay() {
+  if (replay_max_attempts_ == 0 || !replay_.replayable() || cancel_pending_ ||
+      replay_stop_)
+    return false;
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    // lost again before the replay thread was done, it connects once more
+    if (replay_active_) {
+      replay_retry_ = true;
+      return true;
+    }
+    if (replay_attempts_ >= replay_max_attempts_) return false;
+    replay_active_ = true;
+  }
+
+  // the previous replay thread is done, it cleared replay_active_ last
+  if (replay_thread_.joinable()) replay_thread_.join();
+  replay_thread_ = std::thread(&SpeechRecognizer::Impl::replayRecognition,
+                               this);
+  return true;
+}
+
+void SpeechRecognizer::Impl::replayRecognition() {
+  bool retry = true;
+  while (retry) {
+    // the audio thread stops on the audio discarded by connectionLost(), its
+    // backlog is in the replay window
+    if (sendAudioMessage_thread_.joinable()) sendAudioMessage_thread_.join();
+    sendAudioMessage_terminate_ = false;
+
+    std::string reason = "Connection lost";
+    bool connected = false;
+    while (!connected && replay_attempts_ < replay_max_attempts_) {
+      if (open_) closeConnection();
+
+      std::chrono::milliseconds delay = backoff_.delay(replay_attempts_++);
+      {
+        std::unique_lock<std::mutex> lk(lock_);
+        if (cv_.wait_for(lk, delay, [this]() {
+              return replay_stop_ || cancel_pending_ || !recognizing_;
+            }))
+          break;
+        // START_RECOGNITION of the new session arms the audio thread again
+        armed_ = false;
+      }
+      replay_pending_ = true;
+      connected = connect(url_, user_, pass_);
+      // a refused attempt is not an error yet, only the last one is
+      if (!connected)
+        reason = "Failure on reconnecting to server " + url_ + ": " +
+                 connect_error_;
+    }
+
+    if (connected) {
+      ++replays_;
+      ASRSendMessage().createSession(*this);
+    } else if (cancel_pending_) {
+      // canceled while the connection was down, there is nothing to cancel
+      cancelCompleted();
+      finishRecognition();
+    } else if (!replay_stop_ && recognizing_) {
+      replay_pending_ = false;
+      recognitionError(RecognitionError::Code::CONNECTION_FAILURE, reason);
+    }
+
+    std::unique_lock<std::mutex> lk(lock_);
+    retry = connected && replay_retry_;
+    replay_retry_ = false;
+    if (!retry) replay_active_ = false;
+  }
+}
+
+void SpeechRecognizer::Impl::stopReplay() {
+  replay_stop_ = true;
+  { std::unique_lock<std::mutex> lk(lock_); }
+  cv_.notify_all();
+  if (replay_thread_.joinable()) replay_thread_.join();
+  replay_stop_ = false;
+}
+
+void SpeechRecognizer::Impl::audioFinished() {
+  int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  // a replay sends the last packet again, the first one counts
+  int64_t none = 0;
+  if (!audio_end_us_.compare_exchange_strong(none, now)) return;
+
+  if (!hedging_ || hedge_owner_ || !endpoints_ || endpoints_->size() < 2)
+    return;
+  ++hedge_eligible_;
+  std::chrono::milliseconds delay;
+  if (!endpoints_->hedgeDelay(delay)) return;
+
+  std::unique_lock<std::mutex> lk(lock_);
+  if (hedge_stop_ || hedge_thread_.joinable()) return;
+  hedge_thread_ = std::thread(&SpeechRecognizer::Impl::hedgeRecognition,
+                              this, delay);
+}
+
+bool SpeechRecognizer::Impl::claimResult(bool last_segment) {
+  Impl* owner = hedge_owner_ ? hedge_owner_ : this;
+  if (hedge_owner_) {
+    Hedge running = Hedge::kRunning;
+    owner->hedge_.compare_exchange_strong(running, Hedge::kHedge);
+  } else {
+    // the last result also wins before the hedge starts, which then gives
+    // up; earlier segments are not part of the hedged audio
+    Hedge side = hedge_;
+    while ((side == Hedge::kRunning ||
+            (side == Hedge::kNone && last_segment)) &&
+           !hedge_.compare_exchange_weak(side, Hedge::kPrimary)) {
+    }
+  }
+
+  Hedge winner = owner->hedge_;
+  if (hedge_owner_) return winner == Hedge::kHedge;
+  if (winner == Hedge::kHedge) return false;
+
+  // the latencies of the group decide when to hedge and how many
+  // recognitions to admit
+  int64_t end = audio_end_us_;
+  if (last_segment && end != 0 && endpoints_) {
+    int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    result_latency_us_ = now - end;
+    endpoints_->recordLatency(std::chrono::microseconds(now - end));
+  }
+  return true;
 }
 
-void SpeechRecognizer::Impl::sendMessage(std::string &raw_message) {
+void SpeechRecognizer::Impl::hedgeRecognition(
+    std::chrono::milliseconds delay) {
+  std::shared_ptr<AudioSource> audio_src;
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    if (hedge_cv_.wait_for(lk, delay, [this]() {
+          return hedge_stop_ || !recognizing_ || cancel_pending_ ||
+                 replay_active_;
+        }))
+      return;
+    audio_src = audio_src_;
+  }
+
+  // the audio of the segments not recognized yet, which is all of it
+  // unless the utterance has several segments
+  bool finished;
+  std::string audio = replay_.snapshot(finished);
+  if (!audio_src || !replay_.replayable() || !finished) return;
+  {
+    // the primary server may have answered just as the delay ran out
+    std::unique_lock<std::mutex> lk(lock_);
+    if (hedge_stop_ || !recognizing_ || cancel_pending_ || replay_active_)
+      return;
+  }
+  if (!endpoints_->takeHedge()) return;
+
+  std::unique_ptr<Impl> hedge(new Impl());
+  hedge->hedge_owner_ = this;
+  hedge->endpoints_ = endpoints_;
+  hedge->channel_ = channel_;
+  hedge->avoid_endpoint_ = endpoint_;
+  // the decoder of the primary is in use by its I/O thread
+  hedge->decoder_ = ASRResultDecoder(decoder_.options());
+  hedge->raw_results_ = raw_results_;
+  hedge->lm_ = lm_;
+  hedge->recog_params_ = recog_params_;
+  hedge->chunks_.setFormat(audio_src->getAudioFormat());
+  // sent as a replay, in the longest frames, the source is never read
+  hedge->replay_.configure(audio.size());
+  hedge->replay_.append(audio.data(), audio.size());
+  hedge->replay_.finish();
+  hedge->replay_pending_ = true;
+  hedge->audio_src_ = std::make_shared<BufferAudioSource>();
+  hedge->recognizing_ = true;
+
+  // the second server may be at its limit
+  EndpointGroup::Admission admission;
+  admission.priority_ = priority_;
+  admission.wait_ = false;
+  if (!hedge->connect(url_, user_, pass_) ||
+      !endpoints_->admit(hedge->endpoint_, admission))
+    return;
+
+  // from now on the first final result wins, unless the primary server
+  // answered while connecting
+  Hedge none = Hedge::kNone;
+  if (!hedge_.compare_exchange_strong(none, Hedge::kRunning)) {
+    endpoints_->complete(hedge->endpoint_, std::chrono::microseconds(0),
+                         false);
+    return;
+  }
+  ++hedges_;
+  ASRSendMessage().createSession(*hedge);
+
+  // either side ends the recognition, see claimResult()
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    hedge_cv_.wait(lk, [this, &hedge]() {
+      return hedge_stop_ || !recognizing_ || !hedge->recognizing_;
+    });
+  }
+
+  std::string cancel = ASRMessageRequest(Method::CancelRecognition).raw();
+  if (hedge_ == Hedge::kHedge && !hedge->recognizing_) {
+    ++hedge_wins_;
+    // the result is delivered, the slow server is still at it
+    if (!hedge_stop_) {
+      logger_.write(websocketpp::log::elevel::info, "[SEND] " + cancel);
+      hedge_cancel_pending_ = true;
+      sendMessage(cancel);
+    }
+  } else if (hedge->recognizing_) {
+    hedge->sendMessage(cancel);
+    // acknowledged before the connection is closed
+    std::unique_lock<std::mutex> lk(lock_);
+    hedge_cv_.wait_for(lk, std::chrono::seconds(1), [this, &hedge]() {
+      return hedge_stop_ || !hedge->recognizing_;
+    });
+  }
+  endpoints_->complete(hedge->endpoint_, std::chrono::microseconds(0),
+                       false);
+}
+
+void SpeechRecognizer::Impl::releaseAdmission(bool overload) {
+  if (!admitted_.exchange(false)) return;
+  endpoints_->complete(admitted_endpoint_,
+                       std::chrono::microseconds(result_latency_us_),
+                       overload);
+}
+
+void SpeechRecognizer::Impl::stopHedge() {
+  hedge_stop_ = true;
+  std::thread thread;
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    thread = std::move(hedge_thread_);
+  }
+  hedge_cv_.notify_all();
+  if (thread.joinable()) thread.join();
+  hedge_stop_ = false;
+  hedge_ = Hedge::kNone;
+}
+
+void SpeechRecognizer::Impl::offerPartial(PartialCoalescer::Pending partial) {
+  std::chrono::milliseconds wait;
+  if (partials_.offer(std::move(partial), PartialCoalescer::Clock::now(),
+                      wait)) {
+    flushPartial();
+  } else if (wait.count() > 0) {
+    setTimer(wait, [this]() {
+      if (partials_.onTimer(PartialCoalescer::Clock::now())) flushPartial();
+    });
+  }
+}
+
+void SpeechRecognizer::Impl::flushPartial() {
+  PartialCoalescer::Pending partial;
+  if (partials_.take(PartialCoalescer::Clock::now(), partial))
+    deliverPartial(std::move(partial));
+}
+
+void SpeechRecognizer::Impl::deliverPartial(PartialCoalescer::Pending pending) {
+  // Only the partial actually delivered gets its text decoded
+  std::shared_ptr<PartialRecognition> partial;
+  if (!raw_results_ || partials_.filtersText()) {
+    partial = std::make_shared<PartialRecognition>();
+    decoder_.decodePartial(*pending.body_, pending.routing_, *partial);
+    if (!partials_.accept(*partial)) return;
+  }
+
+  if (raw_results_) {
+    RawRecognitionResult raw(pending.body_,
+                             RecognitionResult::Code::PROCESSING, false,
+                             pending.routing_.segment_index,
+                             pending.routing_.last_segment);
+    notifyListeners([raw](RecognitionListener& listener) {
+      listener.onRawRecognitionResult(raw);
+    });
+  } else {
+    std::shared_ptr<const PartialRecognition> shared_partial = partial;
+    notifyListeners([shared_partial](RecognitionListener& listener) {
+      listener.onPartialRecognition(*shared_partial);
+    });
+  }
+}
+
+void SpeechRecognizer::Impl::sendMessage(const std::string &raw_message) {
+  outbound_.sendControl(raw_message);
+}
+
+bool SpeechRecognizer::Impl::sendAudio(const std::string &raw_message) {
+  return outbound_.sendAudio(raw_message);
+}
+
+size_t SpeechRecognizer::Impl::bufferedAmount() {
+  if (secure_) {
+    return WsClient<Client_tls>::buffered_amount(this, &client_tls_);
+  } else {
+    return WsClient<Client>::buffered_amount(this, &client_);
+  }
+}
+
+void SpeechRecognizer::Impl::cancelCompleted() {
+  if (!cancel_pending_.exchange(false)) return;
+
+  int64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - cancel_start_).count();
+  ++cancels_;
+  cancel_latency_us_ = latency;
+  int64_t max = cancel_max_latency_us_;
+  while (latency > max &&
+         !cancel_max_latency_us_.compare_exchange_weak(max, latency)) {
+  }
+}
+
+void SpeechRecognizer::Impl::writeMessage(
+    const std::string &raw_message) {
   if (secure_) {
     WsClient<Client_tls>::send_msg(this, &client_tls_, raw_message);
   } else {
@@ -130,15 +801,43 @@ void SpeechRecognizer::Impl::sendMessage(std::string &raw_message) {
 
 SpeechRecognizer::Impl::Context_ptr SpeechRecognizer::Impl::onTlsInit(
     websocketpp::connection_hdl) {
-  Context_ptr ctx = websocketpp::lib::make_shared<asio::ssl::context>(
-        asio::ssl::context::sslv23);
+  // One context for the whole process: the CA store is read once and the
+  // sessions it negotiates are resumed by the following connections
+  static Context_ptr shared_ctx = []() {
+    Context_ptr ctx = websocketpp::lib::make_shared<asio::ssl::context>(
+          asio::ssl::context::sslv23);
+
+    try {
+      ctx->set_default_verify_paths();
+      ctx->set_options(asio::ssl::context::default_workarounds);
+      ctx->set_verify_mode(asio::ssl::context::verify_none);
+    } catch (std::exception& e) {
+      std::cout << e.what() << std::endl;
+    }
+    TlsSessionCache::global().attach(ctx->native_handle());
+    return ctx;
+  }();
+  return shared_ctx;
+}
+
+void SpeechRecognizer::Impl::onTlsSocketInit(
+    websocketpp::connection_hdl,
+    asio::ssl::stream<asio::ip::tcp::socket>& stream) {
+  using std::placeholders::_1;
+  using std::placeholders::_2;
+  TlsSessionCache::global().prepare(
+      stream.native_handle(), tls_host_,
+      std::bind(&SpeechRecognizer::Impl::tlsHandshakeDone, this, _1, _2));
+}
 
-  try {
-    ctx->set_default_verify_paths();
-    ctx->set_options(asio::ssl::context::default_workarounds);
-    ctx->set_verify_mode(asio::ssl::context::verify_none);
-  } catch (std::exception& e) {
-    std::cout << e.what() << std::endl;
+void SpeechRecognizer::Impl::tlsHandshakeDone(
+    bool resumed, std::chrono::microseconds duration) {
+  int64_t time = duration.count();
+  ++tls_handshakes_;
+  if (resumed) ++tls_resumed_;
+  tls_handshake_time_us_ += time;
+  int64_t max = tls_handshake_max_time_us_;
+  while (time > max &&
+         !tls_handshake_max_time_us_.compare_exchange_weak(max, time)) {
   }
-  return ctx;
 }
@@ -23,6 +23,8 @@
 #include <websocketpp/logger/basic.hpp>
 
 #include <cpqd/asr-client/speech_recog.h>
+#include <cpqd/asr-client/completion_queue.h>
+#include <cpqd/asr-client/endpoint_group.h>
 #include <cpqd/asr-client/language_model_list.h>
 #include <cpqd/asr-client/recognition_result.h>
 #include <cpqd/asr-client/recognition_config.h>
@@ -32,6 +34,7 @@
 #include <condition_variable>
 #include <exception>
 #include <fstream>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <string>
@@ -39,11 +42,22 @@
 #include <atomic>
 #endif
 
+#include "src/asr_result_decoder.h"
+#include "src/callback_strand.h"
+#include "src/chunk_sizer.h"
+#include "src/outbound_scheduler.h"
+#include "src/partial_coalescer.h"
+#include "src/reconnect_backoff.h"
+#include "src/replay_window.h"
+#include "src/result_queue.h"
+#include "src/session_parameters.h"
+
 class SpeechRecognizer::Impl {
  public:
     typedef websocketpp::client<websocketpp::config::asio_tls_client> Client_tls;
     typedef websocketpp::client<websocketpp::config::asio_client> Client;
     typedef websocketpp::lib::shared_ptr<asio::ssl::context> Context_ptr;
+    typedef Client::timer_ptr Timer;
     typedef websocketpp::log::basic<websocketpp::concurrency::basic,
                                     websocketpp::log::alevel>
         AccessLog;
@@ -55,6 +69,9 @@ class SpeechRecognizer::Impl {
 
     enum class SessionStatus{ kNone, kIdle, kListening, kRecognizing };
 
+    /// Which side of a hedged recognition delivered the first final result
+    enum class Hedge { kNone, kRunning, kPrimary, kHedge };
+
     Impl();
 
     ~Impl();
@@ -65,20 +82,167 @@ class SpeechRecognizer::Impl {
 
     void close();
 
+    /// Connect to the server, without reporting a failure
+    bool connect(const std::string& url, const std::string& user,
+                 const std::string& pass);
+
+    /// Close the connection, keeping the audio source of the recognition
+    void closeConnection();
+
+    /// Give the server of the connection back to the endpoint group
+    void releaseEndpoint();
+
+    /// Back to the state of a new recognizer, closing the connection
+    /**
+     * Unlike rebuilding the Impl, the endpoints and their configuration, the
+     * listeners, the log sink and the metrics are kept, so the next
+     * recognition only pays for the connection.
+     */
+    void reset();
+
     void recognitionError(RecognitionError::Code code,
                          std::string message = std::string());
 
-    void sendMessage(std::string& raw_message);
+    /// Call every listener on the callback executor, in arrival order
+    void notifyListeners(std::function<void(RecognitionListener&)> callback);
+
+    /// Send a control message, ahead of any audio not yet written
+    void sendMessage(const std::string& raw_message);
+
+    /// Send an audio message
+    /**
+     * @return false if audio is being discarded by a cancellation.
+     */
+    bool sendAudio(const std::string& raw_message);
+
+    /// Write a message to the connection
+    void writeMessage(const std::string& raw_message);
+
+    /// Bytes waiting in the send queue of the connection
+    size_t bufferedAmount();
+
+    /// Ask the audio thread to stop, waking it up if it is waiting
+    void stopAudioThread();
+
+    /// Called when the server acknowledges a cancellation
+    void cancelCompleted();
+
+    /// Run a handler on the I/O thread after the given delay
+    Timer setTimer(std::chrono::milliseconds delay,
+                   std::function<void()> handler);
+
+    /// Something arrived from the server, the connection is alive
+    void received();
+
+    /// The server answered the keepalive ping
+    void pongReceived();
+
+    /// Start pinging the connection just opened, if configured
+    void startKeepAlive();
+
+    /// Stop pinging, before the connection is closed
+    void stopKeepAlive();
+
+    void keepAliveTick();
+
+    void ping();
+
+    /// The connection died: fail the recognition running, if any
+    void connectionLost(const std::string& reason);
+
+    /// A segment was recognized, its audio won't be replayed
+    void segmentRecognized(const ASRResultDecoder::Routing& routing);
+
+    /// Reconnect and replay the running recognition, if enabled
+    /**
+     * @return false if the recognition can't be replayed.
+     */
+    bool startReplay();
+
+    /// Body of the replay thread
+    void replayRecognition();
+
+    /// Abort a replay in progress and wait for its thread
+    void stopReplay();
+
+    /// The last audio packet was sent, the result may be hedged from now on
+    void audioFinished();
+
+    /// Whether a final result is delivered
+    /**
+     * While a recognition is hedged, the first side to get a final result
+     * wins and the results of the other one are dropped. Always true for a
+     * recognition that is not hedged.
+     *
+     * @param [in] last_segment Whether the result ends the recognition.
+     */
+    bool claimResult(bool last_segment);
+
+    /// Give back the slot of the recognition to the admission control
+    /**
+     * @param [in] overload Whether the recognition failed or timed out.
+     */
+    void releaseAdmission(bool overload);
+
+    /// Body of the hedge thread
+    void hedgeRecognition(std::chrono::milliseconds delay);
+
+    /// Abort a hedge in progress and wait for its thread
+    void stopHedge();
+
+    /// Hold a partial result body until the coalescer lets it through
+    void offerPartial(PartialCoalescer::Pending partial);
+
+    /// Deliver the partial result held by the coalescer, if due
+    void flushPartial();
+
+    /// Deliver a partial result to the listeners
+    void deliverPartial(PartialCoalescer::Pending partial);
 
     void terminateSendMessageThread();
 
+    /// Start the audio thread of the recognition
+    void startAudioThread();
+
+    /// Attach the audio source of a prepared recognition
+    void attachAudio(const std::shared_ptr<AudioSource>& audio_src);
+
+    /// START_RECOGNITION was acknowledged, audio may be sent
+    void recognitionStarted();
+
+    /// Start the input timers now, or once the recognition has started
+    void requestInputTimers();
+
+    /// Queue a final result and wake up the threads waiting for it
+    void pushResult(ResultQueue::Entry entry);
+
+    /// Move out the final results received, materializing raw ones
+    std::vector<RecognitionResult> takeResults();
+
+    /// Flag the recognition as finished and wake up the waiters
+    void finishRecognition();
+
+    /// Post the completion event of the recognition, once
+    void postCompletion();
+
+    /// Serialized parameters of a per-recognition config, cached
+    std::shared_ptr<const SessionParameters::Headers> parametersOf(
+        const std::shared_ptr<const RecognitionConfig>& config);
+
     Context_ptr onTlsInit(websocketpp::connection_hdl);
+    void onTlsSocketInit(websocketpp::connection_hdl,
+                         asio::ssl::stream<asio::ip::tcp::socket>& stream);
+    void tlsHandshakeDone(bool resumed, std::chrono::microseconds duration);
 
     Client client_;
     Client_tls client_tls_;
 
     std::atomic<bool> secure_{false};
 
+    // endpoints are initialized on their first connection only
+    bool client_ready_ = false;
+    bool client_tls_ready_ = false;
+
     AccessLog logger_;
     std::ofstream out_;
     std::mutex lock_;
@@ -89,14 +253,126 @@ class SpeechRecognizer::Impl {
     std::atomic<bool> sendAudioMessage_terminate_{false};
     std::atomic<bool> open_{false};
     std::atomic<Status> status_{Status::kConnecting};
+    // why the last connection attempt failed, the caller reports it
+    std::string connect_error_;
     std::atomic<SessionStatus> session_status_{SessionStatus::kNone};
     std::shared_ptr<AudioSource> audio_src_ = nullptr;
-    std::unique_ptr<LanguageModelList> lm_ = nullptr;
+    // recognition prepared ahead of its audio, and acknowledged by the server
+    std::atomic<bool> prepared_{false};
+    bool armed_ = false;
+    // START_INPUT_TIMERS waiting for START_RECOGNITION to be acknowledged
+    bool input_timers_requested_ = false;
+    bool defer_input_timers_ = false;
+    std::shared_ptr<const LanguageModelList> lm_ = nullptr;
     std::unique_ptr<RecognitionConfig> config_ = nullptr;
+    std::shared_ptr<const SessionParameters::Headers> config_headers_;
+    std::weak_ptr<const RecognitionConfig> override_config_;
+    std::shared_ptr<const SessionParameters::Headers> override_headers_;
+    // parameters of the running recognition, and the ones set on the session
+    std::shared_ptr<const SessionParameters::Headers> recog_params_;
+    SessionParameters session_params_;
     std::vector<std::unique_ptr<RecognitionListener>> listener_;
-    std::vector<RecognitionResult> result_;
+    std::unique_ptr<ResultQueue> result_;
+    ASRResultDecoder decoder_;
+    bool raw_results_ = false;
+    PartialCoalescer partials_;
     std::exception_ptr eptr_ = nullptr;
+    std::shared_ptr<CompletionQueue> completion_queue_ = nullptr;
+    uint64_t completion_id_ = 0;
+    std::atomic<bool> completion_pending_{false};
     std::thread sendAudioMessage_thread_;
+    std::mutex audio_lock_;
+    std::condition_variable audio_cv_;
+    OutboundScheduler outbound_;
+    ChunkSizer chunks_;
+    std::chrono::steady_clock::time_point start_sent_;
+
+    std::atomic<uint64_t> connections_{0};
+    std::atomic<uint64_t> connections_lost_{0};
+
+    // server of the connection, when picked from an endpoint group
+    std::shared_ptr<EndpointGroup> endpoints_ = nullptr;
+    std::string channel_;
+    size_t endpoint_ = 0;
+    std::atomic<bool> endpoint_held_{false};
+
+    // reconnection of a running recognition, replaying its audio
+    std::string url_;
+    std::string user_;
+    std::string pass_;
+    ReplayWindow replay_;
+    ReconnectBackoff backoff_;
+    unsigned int replay_max_attempts_ = 0;
+    std::atomic<unsigned int> replay_attempts_{0};
+    std::thread replay_thread_;
+    // replay_active_ and replay_retry_ change under lock_
+    std::atomic<bool> replay_active_{false};
+    bool replay_retry_ = false;
+    std::atomic<bool> replay_stop_{false};
+    // the next audio thread sends the replay window first
+    std::atomic<bool> replay_pending_{false};
+    std::atomic<uint64_t> replays_{0};
+    std::atomic<uint64_t> replayed_bytes_{0};
+
+    // time the audio waited for the uplink shaper
+    std::atomic<int64_t> uplink_throttled_us_{0};
+
+    // hedging, a late recognition is sent to a second server of the group
+    // too. The second recognition runs on an Impl of its own, whose results
+    // go to hedge_owner_.
+    bool hedging_ = false;
+    Impl* hedge_owner_ = nullptr;
+    size_t avoid_endpoint_ = EndpointGroup::kNoEndpoint;
+    std::atomic<Hedge> hedge_{Hedge::kNone};
+    std::thread hedge_thread_;
+    std::condition_variable hedge_cv_;
+    std::atomic<bool> hedge_stop_{false};
+    // the response to the cancel of the slower side is not for the
+    // application
+    std::atomic<bool> hedge_cancel_pending_{false};
+    // steady clock microseconds, 0 while the audio goes on
+    std::atomic<int64_t> audio_end_us_{0};
+    std::atomic<uint64_t> hedge_eligible_{0};
+    std::atomic<uint64_t> hedges_{0};
+    std::atomic<uint64_t> hedge_wins_{0};
+
+    // slot of the running recognition in the admission control of the group
+    std::atomic<bool> admitted_{false};
+    size_t admitted_endpoint_ = 0;
+    RecognitionPriority priority_ = RecognitionPriority::NORMAL;
+    std::string tenant_;
+    // end of the audio to the last final result, 0 if there was none
+    std::atomic<int64_t> result_latency_us_{0};
+    std::atomic<uint64_t> admission_rejections_{0};
+
+    // keepalive, the time of the last message is in steady clock microseconds
+    std::chrono::milliseconds ping_interval_{0};
+    std::chrono::milliseconds pong_timeout_{0};
+    std::chrono::milliseconds keepalive_tick_{0};
+    std::atomic<int64_t> last_receive_us_{0};
+    std::atomic<bool> ping_pending_{false};
+    std::atomic<uint64_t> pings_{0};
+    std::mutex keepalive_lock_;
+    Timer keepalive_timer_;
+    bool keepalive_running_ = false;
+
+    // "host:port" of the TLS connection, sessions are resumed per server
+    std::string tls_host_;
+    std::atomic<uint64_t> tls_handshakes_{0};
+    std::atomic<uint64_t> tls_resumed_{0};
+    std::atomic<int64_t> tls_handshake_time_us_{0};
+    std::atomic<int64_t> tls_handshake_max_time_us_{0};
+    std::atomic<uint64_t> sessions_{0};
+
+    std::atomic<bool> cancel_pending_{false};
+    std::chrono::steady_clock::time_point cancel_start_;
+    std::atomic<uint64_t> cancels_{0};
+    std::atomic<int64_t> cancel_latency_us_{0};
+    std::atomic<int64_t> cancel_max_latency_us_{0};
+
+    // Last member: pending callbacks are drained before the listeners and
+    // the rest of the state they use are destroyed
+    std::unique_ptr<CallbackStrand> callbacks_;
 };
 
 #endif  // SRC_SPEECH_RECOG_IMPL_H_
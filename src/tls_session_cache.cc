@@ -0,0 +1,124 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include "src/tls_session_cache.h"
+
+#include <utility>
+
+// Per connection state, owned by the SSL object through its ex_data
+struct TlsSessionCache::Handshake {
+  TlsSessionCache* cache;
+  std::string host;
+  HandshakeObserver observer;
+  std::chrono::steady_clock::time_point start;
+  bool started = false;
+  bool done = false;
+};
+
+TlsSessionCache::~TlsSessionCache() { clear(); }
+
+TlsSessionCache& TlsSessionCache::global() {
+  static TlsSessionCache cache;
+  return cache;
+}
+
+int TlsSessionCache::handshakeIndex() {
+  static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr,
+                                          &TlsSessionCache::freeHandshake);
+  return index;
+}
+
+void TlsSessionCache::freeHandshake(void*, void* ptr, CRYPTO_EX_DATA*, int,
+                                    long, void*) {
+  delete static_cast<Handshake*>(ptr);
+}
+
+void TlsSessionCache::attach(SSL_CTX* ctx) {
+  // Sessions live in this cache only, the context one is not shared by
+  // host and never looked up by clients
+  SSL_CTX_set_session_cache_mode(
+      ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(ctx, &TlsSessionCache::onNewSession);
+  SSL_CTX_set_info_callback(ctx, &TlsSessionCache::onInfo);
+}
+
+void TlsSessionCache::prepare(SSL* ssl, const std::string& host,
+                              HandshakeObserver observer) {
+  Handshake* handshake = new Handshake();
+  handshake->cache = this;
+  handshake->host = host;
+  handshake->observer = std::move(observer);
+  if (!SSL_set_ex_data(ssl, handshakeIndex(), handshake)) {
+    delete handshake;
+    return;
+  }
+
+  std::unique_lock<std::mutex> lk(lock_);
+  auto it = sessions_.find(host);
+  // the connection takes its own reference to the session
+  if (it != sessions_.end()) SSL_set_session(ssl, it->second);
+}
+
+size_t TlsSessionCache::size() const {
+  std::unique_lock<std::mutex> lk(lock_);
+  return sessions_.size();
+}
+
+void TlsSessionCache::clear() {
+  std::unique_lock<std::mutex> lk(lock_);
+  for (auto& entry : sessions_) SSL_SESSION_free(entry.second);
+  sessions_.clear();
+}
+
+void TlsSessionCache::store(const std::string& host, SSL_SESSION* session) {
+  std::unique_lock<std::mutex> lk(lock_);
+  SSL_SESSION*& cached = sessions_[host];
+  if (cached) SSL_SESSION_free(cached);
+  cached = session;
+}
+
+int TlsSessionCache::onNewSession(SSL* ssl, SSL_SESSION* session) {
+  Handshake* handshake =
+      static_cast<Handshake*>(SSL_get_ex_data(ssl, handshakeIndex()));
+  if (!handshake) return 0;
+
+  // returning 1 keeps the reference to the session
+  handshake->cache->store(handshake->host, session);
+  return 1;
+}
+
+void TlsSessionCache::onInfo(const SSL* ssl, int where, int) {
+  Handshake* handshake =
+      static_cast<Handshake*>(SSL_get_ex_data(ssl, handshakeIndex()));
+  if (!handshake) return;
+
+  // TLSv1.3 post handshake messages, e.g. tickets, report a handshake
+  // of their own, only the first one is timed
+  if ((where & SSL_CB_HANDSHAKE_START) && !handshake->started) {
+    handshake->started = true;
+    handshake->start = std::chrono::steady_clock::now();
+  }
+  if ((where & SSL_CB_HANDSHAKE_DONE) && handshake->started &&
+      !handshake->done) {
+    handshake->done = true;
+    if (handshake->observer) {
+      bool resumed = SSL_session_reused(const_cast<SSL*>(ssl)) != 0;
+      handshake->observer(
+          resumed, std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - handshake->start));
+    }
+  }
+}
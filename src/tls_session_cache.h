@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#ifndef SRC_TLS_SESSION_CACHE_H_
+#define SRC_TLS_SESSION_CACHE_H_
+
+#include <openssl/ssl.h>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+/// Client TLS sessions kept across connections, keyed by server
+/**
+ * A connection prepared with the host it connects to offers the session
+ * negotiated by the previous connection to the same host, and the server
+ * may resume it with an abbreviated handshake. Sessions are taken from the
+ * new session callback, so TLSv1.3 tickets sent after the handshake are
+ * cached as well.
+ *
+ * The SSL_CTX the connections are created from must be attached once.
+ */
+class TlsSessionCache {
+ public:
+  /// Called when the handshake of a prepared connection completes
+  typedef std::function<void(bool resumed, std::chrono::microseconds)>
+      HandshakeObserver;
+
+  TlsSessionCache() = default;
+  ~TlsSessionCache();
+
+  TlsSessionCache(const TlsSessionCache&) = delete;
+  TlsSessionCache& operator=(const TlsSessionCache&) = delete;
+
+  /// Cache shared by the whole process
+  static TlsSessionCache& global();
+
+  /// Install the cache callbacks on a client context
+  void attach(SSL_CTX* ctx);
+
+  /// Offer the session cached for the host and time the handshake
+  /**
+   * Must be called before the handshake starts.
+   *
+   * @param [in] host Server the connection is opened to, "host:port".
+   * @param [in] observer Optional, called once on handshake completion.
+   */
+  void prepare(SSL* ssl, const std::string& host,
+               HandshakeObserver observer = nullptr);
+
+  /// Number of hosts with a cached session
+  size_t size() const;
+
+  /// Drop every cached session
+  void clear();
+
+ private:
+  struct Handshake;
+
+  static int handshakeIndex();
+  static void freeHandshake(void* parent, void* ptr, CRYPTO_EX_DATA* ad,
+                            int index, long argl, void* argp);
+  static int onNewSession(SSL* ssl, SSL_SESSION* session);
+  static void onInfo(const SSL* ssl, int where, int ret);
+
+  void store(const std::string& host, SSL_SESSION* session);
+
+  mutable std::mutex lock_;
+  std::map<std::string, SSL_SESSION*> sessions_;
+};
+
+#endif  // SRC_TLS_SESSION_CACHE_H_
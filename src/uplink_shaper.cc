@@ -0,0 +1,97 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <cpqd/asr-client/uplink_shaper.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+const int UplinkShaper::kMeterSeconds;
+
+UplinkShaper::UplinkShaper(const Options& options) { configure(options); }
+
+UplinkShaper& UplinkShaper::global() {
+  static UplinkShaper shaper;
+  return shaper;
+}
+
+void UplinkShaper::configure(const Options& options) {
+  if ((options.live_rate_ > 0 && options.live_burst_ == 0) ||
+      (options.bulk_rate_ > 0 && options.bulk_burst_ == 0))
+    throw std::invalid_argument("Uplink burst must be positive");
+
+  std::unique_lock<std::mutex> lk(lock_);
+  Clock::time_point now = Clock::now();
+  live_.rate = static_cast<double>(options.live_rate_);
+  live_.burst = static_cast<double>(options.live_burst_);
+  bulk_.rate = static_cast<double>(options.bulk_rate_);
+  bulk_.burst = static_cast<double>(options.bulk_burst_);
+  for (Bucket* b : {&live_, &bulk_}) {
+    b->tokens = b->burst;
+    b->refilled = now;
+  }
+}
+
+std::chrono::microseconds UplinkShaper::reserve(UplinkClass uplink,
+                                                size_t bytes) {
+  std::unique_lock<std::mutex> lk(lock_);
+  Bucket& b = bucket(uplink);
+  Clock::time_point now = Clock::now();
+
+  decay(b, now);
+  b.meter += bytes;
+  b.stats.bytes_ += bytes;
+  if (b.rate <= 0) return std::chrono::microseconds(0);
+
+  double elapsed =
+      std::chrono::duration<double>(now - b.refilled).count();
+  b.tokens = std::min(b.burst, b.tokens + elapsed * b.rate);
+  b.refilled = now;
+
+  // the tokens go into debt, the messages after this one wait for it too
+  b.tokens -= bytes;
+  if (b.tokens >= 0) return std::chrono::microseconds(0);
+
+  std::chrono::microseconds hold(
+      static_cast<int64_t>(std::ceil(-b.tokens / b.rate * 1e6)));
+  ++b.stats.throttles_;
+  b.stats.throttled_time_ += hold;
+  return hold;
+}
+
+UplinkShaper::Stats UplinkShaper::stats(UplinkClass uplink) {
+  std::unique_lock<std::mutex> lk(lock_);
+  Bucket& b = bucket(uplink);
+  decay(b, Clock::now());
+
+  Stats stats = b.stats;
+  stats.bytes_per_second_ = b.meter / kMeterSeconds;
+  return stats;
+}
+
+UplinkShaper::Bucket& UplinkShaper::bucket(UplinkClass uplink) {
+  return uplink == UplinkClass::LIVE ? live_ : bulk_;
+}
+
+void UplinkShaper::decay(Bucket& bucket, Clock::time_point now) {
+  double elapsed =
+      std::chrono::duration<double>(now - bucket.metered).count();
+  // the first message starts the meter
+  if (bucket.metered != Clock::time_point())
+    bucket.meter *= std::exp(-elapsed / kMeterSeconds);
+  bucket.metered = now;
+}
@@ -21,6 +21,7 @@
 #include "src/process_result.h"
 #include "src/speech_recog_impl.h"
 
+#include <functional>
 #include <string>
 
 template <typename EndpointType>
@@ -28,16 +29,13 @@ class WsClient {
  public:
   typedef typename EndpointType::connection_ptr connection_ptr;
 
-  static void init(SpeechRecognizer::Impl* impl, EndpointType* client_config,
-                   const std::string& url,
-                   std::string user = std::string(),
-                   std::string pass = std::string()) {
+  // Configure the endpoint, once in its lifetime
+  static void init(SpeechRecognizer::Impl* impl, EndpointType* client_config) {
     client_config->clear_access_channels(websocketpp::log::alevel::all);
     client_config->clear_error_channels(websocketpp::log::alevel::all);
 
     // Initialize the Asio transport policy
     client_config->init_asio();
-    client_config->start_perpetual();
 
     using std::placeholders::_1;
     using std::placeholders::_2;
@@ -51,6 +49,27 @@ class WsClient {
     client_config->set_close_handler(
         std::bind(WsClient<EndpointType>::on_close, impl, _1));
 
+    // Keepalive, a ping without pong in time marks the connection dead
+    if (impl->ping_interval_.count() > 0) {
+      client_config->set_pong_handler(
+          std::bind(WsClient<EndpointType>::on_pong, impl, _1, _2));
+      client_config->set_pong_timeout_handler(std::bind(
+          WsClient<EndpointType>::on_pong_timeout, impl, client_config, _1,
+          _2));
+      client_config->set_pong_timeout(impl->pong_timeout_.count());
+    }
+  }
+
+  // Open a connection, the endpoint is reused from the previous one
+  static void connect(SpeechRecognizer::Impl* impl,
+                      EndpointType* client_config, const std::string& url,
+                      std::string user = std::string(),
+                      std::string pass = std::string()) {
+    // run() of the previous connection has returned, the io_service must be
+    // restarted before running it again
+    client_config->reset();
+    client_config->start_perpetual();
+
     // Create a new connection to the given URI
     websocketpp::lib::error_code err_code;
     connection_ptr connection = client_config->get_connection(url, err_code);
@@ -81,16 +100,46 @@ class WsClient {
   }
 
   static void send_msg(SpeechRecognizer::Impl* impl,
-                       EndpointType* client_config, std::string& raw_message) {
+                       EndpointType* client_config,
+                       const std::string& raw_message) {
     try {
       client_config->send(impl->connection_hdl_, raw_message,
                           websocketpp::frame::opcode::binary);
+    } catch (const std::exception& e) {
+      impl->recognitionError(RecognitionError::Code::FAILURE,
+                             std::string("Send failure: ") + e.what());
     } catch (...) {
-      impl->eptr_ = std::current_exception();
-      impl->cv_.notify_one();
+      impl->recognitionError(RecognitionError::Code::FAILURE, "Send failure");
+    }
+  }
+
+  static size_t buffered_amount(SpeechRecognizer::Impl* impl,
+                                EndpointType* client_config) {
+    websocketpp::lib::error_code err_code;
+    connection_ptr connection =
+        client_config->get_con_from_hdl(impl->connection_hdl_, err_code);
+    if (err_code || !connection) return 0;
+    return connection->get_buffered_amount();
+  }
+
+  static void ping(SpeechRecognizer::Impl* impl, EndpointType* client_config) {
+    websocketpp::lib::error_code err_code;
+    client_config->ping(impl->connection_hdl_, std::string(), err_code);
+    if (err_code) {
+      impl->logger_.write(websocketpp::log::alevel::app,
+                          "Ping Error: " + err_code.message());
     }
   }
 
+  static typename EndpointType::timer_ptr set_timer(
+      EndpointType* client_config, long milliseconds,
+      std::function<void()> handler) {
+    return client_config->set_timer(
+        milliseconds, [handler](const websocketpp::lib::error_code& err_code) {
+          if (!err_code) handler();
+        });
+  }
+
   static void close(SpeechRecognizer::Impl* impl, EndpointType* client_config) {
     client_config->stop_perpetual();
     websocketpp::lib::error_code err_code;
@@ -117,26 +166,48 @@ class WsClient {
 
   static void on_close(SpeechRecognizer::Impl* impl,
                        websocketpp::connection_hdl) {
+    // still open: the server or the network closed it, not close()
+    impl->connectionLost("Connection closed by the server");
     impl->status_ = SpeechRecognizer::Impl::Status::kClose;
     impl->cv_.notify_one();
   }
 
+  static void on_pong(SpeechRecognizer::Impl* impl,
+                      websocketpp::connection_hdl, std::string) {
+    impl->pongReceived();
+  }
+
+  static void on_pong_timeout(SpeechRecognizer::Impl* impl,
+                              EndpointType* client_config,
+                              websocketpp::connection_hdl hdl, std::string) {
+    impl->connectionLost("No pong from the server within " +
+                         std::to_string(impl->pong_timeout_.count()) + " ms");
+    websocketpp::lib::error_code err_code;
+    client_config->close(hdl, websocketpp::close::status::going_away, "",
+                         err_code);
+  }
+
   static void on_fail(SpeechRecognizer::Impl* impl, EndpointType* client_config,
                       websocketpp::connection_hdl hdl) {
     connection_ptr con = client_config->get_con_from_hdl(hdl);
     std::string server = con->get_response_header("Server");
     std::string reason = con->get_ec().message();
 
-    impl->eptr_ = std::make_exception_ptr(std::invalid_argument(reason));
-    impl->status_ = SpeechRecognizer::Impl::Status::kFailed;
+    // not an error of the recognition yet: open() throws, a replay tries
+    // again
+    {
+      std::unique_lock<std::mutex> lk(impl->lock_);
+      impl->connect_error_ = reason;
+      impl->status_ = SpeechRecognizer::Impl::Status::kFailed;
+    }
     impl->cv_.notify_one();
   }
 
   static void on_message(SpeechRecognizer::Impl* impl,
                          websocketpp::connection_hdl,
                          typename EndpointType::message_ptr msg) {
-    websocketpp::lib::error_code err_code;
-    std::string payload = msg->get_payload();
+    impl->received();
+    const std::string& payload = msg->get_payload();
 
     ASRMessageResponse response;
     response.consume(payload);
@@ -156,7 +227,7 @@ class WsClient {
     root->handle(*impl, response);
 
     impl->logger_.write(websocketpp::log::elevel::info,
-                        "[RECEIVE] " + response.raw());
+                        "[RECEIVE] " + payload);
   }
 };
 
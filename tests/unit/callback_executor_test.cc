@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <cpqd/asr-client/callback_executor.h>
+
+#include "src/callback_strand.h"
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+TEST(CallbackExecutorTest, inlineOrder) {
+  CallbackStrand strand(CallbackExecutor::inlineExecutor());
+  std::vector<int> calls;
+
+  strand.post([&calls, &strand]() {
+    // posted from inside a callback, runs after it returns
+    strand.post([&calls]() { calls.push_back(2); });
+    calls.push_back(1);
+  });
+  strand.post([&calls]() { calls.push_back(3); });
+
+  ASSERT_EQ(3, calls.size());
+  EXPECT_EQ(1, calls[0]);
+  EXPECT_EQ(2, calls[1]);
+  EXPECT_EQ(3, calls[2]);
+}
+
+TEST(CallbackExecutorTest, dedicatedThreadOrder) {
+  std::shared_ptr<CallbackExecutor> executor =
+      CallbackExecutor::dedicatedThread();
+  CallbackStrand strand(executor);
+  std::vector<int> calls;
+  std::thread::id caller = std::this_thread::get_id();
+  std::atomic<bool> other_thread{true};
+
+  for (int i = 0; i < 100; ++i) {
+    strand.post([&calls, &other_thread, caller, i]() {
+      if (std::this_thread::get_id() == caller) other_thread = false;
+      calls.push_back(i);
+    });
+  }
+  strand.drain();
+
+  EXPECT_TRUE(other_thread);
+  ASSERT_EQ(100, calls.size());
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(i, calls[i]);
+}
+
+TEST(CallbackExecutorTest, metrics) {
+  CallbackStrand strand(CallbackExecutor::dedicatedThread());
+
+  strand.post([]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  });
+  strand.post([]() { throw std::runtime_error("listener failure"); });
+  strand.post([]() {});
+  strand.drain();
+
+  RecognizerMetrics metrics;
+  strand.metrics(metrics);
+  EXPECT_EQ(0, metrics.callback_queue_depth_);
+  EXPECT_LE(1, metrics.callback_queue_max_depth_);
+  EXPECT_EQ(3, metrics.callbacks_);
+  EXPECT_EQ(1, metrics.callback_errors_);
+  EXPECT_LE(20000, metrics.callback_max_time_.count());
+}
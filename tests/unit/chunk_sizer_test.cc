@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "src/chunk_sizer.h"
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+// 8 kHz, 16 bits: 16 bytes per millisecond
+TEST(ChunkSizerTest, liveFrames) {
+  ChunkSizer chunks;
+  chunks.configure(AudioPacing::LIVE, 20, 500);
+  chunks.setFormat(AudioFormat());
+
+  EXPECT_EQ(0, chunks.next(0, false));
+  EXPECT_EQ(0, chunks.next(100, false));
+  EXPECT_EQ(320, chunks.next(1000, false));
+  EXPECT_EQ(std::chrono::milliseconds(20), chunks.pollInterval());
+
+  // a backlog is flushed with long frames
+  EXPECT_EQ(8000, chunks.next(10000, false));
+
+  // the end of the stream is sent as is
+  EXPECT_EQ(101, chunks.next(101, true));
+}
+
+TEST(ChunkSizerTest, batchFrames) {
+  ChunkSizer chunks;
+  chunks.configure(AudioPacing::BATCH, 20, 500);
+  chunks.setFormat(AudioFormat());
+
+  EXPECT_EQ(0, chunks.next(4000, false));
+  EXPECT_EQ(8000, chunks.next(20000, false));
+  EXPECT_EQ(4000, chunks.next(4000, true));
+}
+
+TEST(ChunkSizerTest, autoFollowsBacklog) {
+  ChunkSizer chunks;
+  chunks.configure(AudioPacing::AUTO, 20, 500);
+  chunks.setFormat(AudioFormat());
+
+  // whole backlog in one frame, aligned to a sample
+  EXPECT_EQ(0, chunks.next(300, false));
+  EXPECT_EQ(1000, chunks.next(1001, false));
+  EXPECT_EQ(8000, chunks.next(20000, false));
+
+  // no frame shorter than a quarter of the round trip
+  chunks.observeRtt(std::chrono::milliseconds(400));
+  EXPECT_EQ(std::chrono::milliseconds(400), chunks.rtt());
+  EXPECT_EQ(0, chunks.next(1000, false));
+  EXPECT_EQ(1600, chunks.next(1600, false));
+}
+
+TEST(ChunkSizerTest, sampleAlignment) {
+  AudioFormat fmt;
+  fmt.bits_per_sample_ = 8;
+  fmt.sample_rate_ = 11025;
+
+  ChunkSizer chunks;
+  chunks.configure(AudioPacing::LIVE, 20, 40);
+  chunks.setFormat(fmt);
+  EXPECT_EQ(220, chunks.next(300, false));
+
+  fmt.bits_per_sample_ = 16;
+  chunks.setFormat(fmt);
+  EXPECT_EQ(440, chunks.next(800, false));
+  EXPECT_EQ(0, chunks.bytes(std::chrono::microseconds(12345)) % 2);
+}
@@ -0,0 +1,70 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include <cpqd/asr-client/completion_queue.h>
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+TEST(CompletionQueueTest, pollAndWait) {
+  CompletionQueue queue;
+  CompletionQueue::Event event;
+
+  EXPECT_FALSE(queue.poll(event));
+  EXPECT_FALSE(queue.waitAny(event, std::chrono::milliseconds(10)));
+
+  std::thread producer([&queue]() {
+    for (uint64_t id = 1; id <= 3; ++id) {
+      CompletionQueue::Event ev;
+      ev.id_ = id;
+      ev.results_.push_back(RecognitionResult(RecognitionResult::RECOGNIZED));
+      if (id == 3)
+        ev.error_ = std::make_exception_ptr(std::runtime_error("failure"));
+      queue.post(std::move(ev));
+    }
+  });
+
+  for (uint64_t id = 1; id <= 3; ++id) {
+    ASSERT_TRUE(queue.waitAny(event, std::chrono::seconds(5)));
+    EXPECT_EQ(id, event.id_);
+    EXPECT_EQ(1, event.results_.size());
+    EXPECT_EQ(id != 3, event.ok());
+  }
+  producer.join();
+  EXPECT_THROW(event.rethrow(), std::runtime_error);
+  EXPECT_EQ(0, queue.size());
+}
+
+TEST(CompletionQueueTest, shutdown) {
+  CompletionQueue queue;
+  CompletionQueue::Event event;
+
+  std::thread stopper([&queue]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.shutdown();
+  });
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(queue.waitAny(event, std::chrono::seconds(10)));
+  EXPECT_GT(std::chrono::seconds(5), std::chrono::steady_clock::now() - start);
+  stopper.join();
+}
@@ -0,0 +1,415 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cpqd/asr-client/endpoint_group.h>
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+const std::vector<std::string> urls = {"ws://a:8025/asr", "ws://b:8025/asr",
+                                       "wss://c:8025/asr"};
+
+EndpointGroup::Options withPolicy(EndpointPolicy policy) {
+  EndpointGroup::Options options;
+  options.policy_ = policy;
+  return options;
+}
+
+// Recognitions queued on the first server of a full group, in the order
+// they get a slot
+class AdmissionQueue {
+ public:
+  explicit AdmissionQueue(EndpointGroup& group) : group_(group) {}
+
+  ~AdmissionQueue() {
+    for (std::thread& t : waiters_) t.join();
+  }
+
+  void push(const std::string& name, const EndpointGroup::Admission& a) {
+    size_t queued = group_.stats()[0].queued_;
+    waiters_.emplace_back([this, name, a]() {
+      if (!group_.admit(0, a)) return;
+      std::unique_lock<std::mutex> lk(lock_);
+      admitted_.push_back(name);
+    });
+    // one at a time, the arrival order breaks ties
+    while (group_.stats()[0].queued_ == queued)
+      std::this_thread::yield();
+  }
+
+  // free the slots one by one
+  std::vector<std::string> drain() {
+    for (size_t i = 0; i < waiters_.size(); ++i) {
+      group_.complete(0, std::chrono::microseconds(0), false);
+      while (admitted() == i) std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lk(lock_);
+    return admitted_;
+  }
+
+ private:
+  size_t admitted() {
+    std::unique_lock<std::mutex> lk(lock_);
+    return admitted_.size();
+  }
+
+  EndpointGroup& group_;
+  std::vector<std::thread> waiters_;
+  std::mutex lock_;
+  std::vector<std::string> admitted_;
+};
+
+EndpointGroup::Admission admission(RecognitionPriority priority,
+                                   const std::string& tenant) {
+  EndpointGroup::Admission a;
+  a.priority_ = priority;
+  a.tenant_ = tenant;
+  return a;
+}
+
+TEST(EndpointGroupTest, invalidUrls) {
+  ASSERT_THROW(EndpointGroup(std::vector<std::string>()),
+               std::invalid_argument);
+  ASSERT_THROW(EndpointGroup({"ws://a:8025/asr", "http://b/asr"}),
+               std::invalid_argument);
+}
+
+TEST(EndpointGroupTest, roundRobin) {
+  EndpointGroup group(urls);
+  for (size_t i = 0; i < 6; ++i) {
+    size_t endpoint = group.acquire();
+    EXPECT_EQ(i % urls.size(), endpoint);
+    EXPECT_EQ(urls[endpoint], group.url(endpoint));
+  }
+  EXPECT_EQ(2u, group.stats()[0].outstanding_);
+}
+
+TEST(EndpointGroupTest, leastOutstanding) {
+  EndpointGroup group(urls, withPolicy(EndpointPolicy::LEAST_OUTSTANDING));
+  size_t a = group.acquire();
+  size_t b = group.acquire();
+  size_t c = group.acquire();
+  EXPECT_NE(a, b);
+  EXPECT_NE(b, c);
+  EXPECT_NE(a, c);
+
+  group.release(b);
+  EXPECT_EQ(b, group.acquire());
+  group.release(c);
+  group.release(c);
+  EXPECT_EQ(c, group.acquire());
+}
+
+TEST(EndpointGroupTest, latencyWeighted) {
+  EndpointGroup group(urls, withPolicy(EndpointPolicy::LATENCY_WEIGHTED));
+  // every server is measured once before the weights apply
+  std::vector<bool> seen(urls.size());
+  for (size_t i = 0; i < urls.size(); ++i) seen[group.acquire()] = true;
+  EXPECT_EQ(std::vector<bool>(urls.size(), true), seen);
+
+  group.succeeded(0, std::chrono::milliseconds(100));
+  group.succeeded(1, std::chrono::milliseconds(1));
+  group.succeeded(2, std::chrono::milliseconds(100));
+
+  std::vector<int> picks(urls.size());
+  for (int i = 0; i < 1000; ++i) ++picks[group.acquire()];
+  EXPECT_GT(picks[1], 900);
+  EXPECT_EQ(std::chrono::milliseconds(1), group.stats()[1].setup_time_);
+}
+
+TEST(EndpointGroupTest, channelAffinity) {
+  EndpointGroup group(urls, withPolicy(EndpointPolicy::CHANNEL_AFFINITY));
+  std::vector<size_t> home;
+  for (int channel = 0; channel < 30; ++channel) {
+    std::string id = "channel-" + std::to_string(channel);
+    home.push_back(group.acquire(id));
+    EXPECT_EQ(home.back(), group.acquire(id));
+  }
+
+  // only the channels of a server taken out move
+  for (int i = 0; i < 3; ++i) group.failed(0);
+  for (int channel = 0; channel < 30; ++channel) {
+    size_t endpoint = group.acquire("channel-" + std::to_string(channel));
+    EXPECT_NE(0u, endpoint);
+    if (home[channel] != 0) {
+      EXPECT_EQ(home[channel], endpoint);
+    }
+  }
+}
+
+TEST(EndpointGroupTest, circuitBreaker) {
+  EndpointGroup::Options options;
+  options.failure_threshold_ = 2;
+  options.open_time_ = std::chrono::milliseconds(50);
+  EndpointGroup group({"ws://a:8025/asr", "ws://b:8025/asr"}, options);
+
+  group.failed(0);
+  EXPECT_TRUE(group.stats()[0].available_);
+  group.failed(0);
+  EXPECT_FALSE(group.stats()[0].available_);
+  EXPECT_EQ(1u, group.stats()[0].ejections_);
+  for (int i = 0; i < 4; ++i) EXPECT_EQ(1u, group.acquire());
+
+  // a single probe after the open time
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  EXPECT_EQ(0u, group.acquire());
+  EXPECT_EQ(1u, group.acquire());
+  EXPECT_EQ(1u, group.acquire());
+
+  // the probe failed, out again
+  group.failed(0);
+  EXPECT_EQ(2u, group.stats()[0].ejections_);
+  EXPECT_EQ(1u, group.acquire());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  EXPECT_EQ(0u, group.acquire());
+  group.succeeded(0, std::chrono::milliseconds(1));
+  EXPECT_TRUE(group.stats()[0].available_);
+  EXPECT_EQ(0u, group.stats()[0].failures_);
+}
+
+TEST(EndpointGroupTest, slowSetup) {
+  EndpointGroup::Options options;
+  options.failure_threshold_ = 1;
+  options.slow_setup_ = std::chrono::milliseconds(200);
+  EndpointGroup group({"ws://a:8025/asr", "ws://b:8025/asr"}, options);
+
+  group.succeeded(1, std::chrono::milliseconds(100));
+  EXPECT_TRUE(group.stats()[1].available_);
+  group.succeeded(0, std::chrono::milliseconds(500));
+  EXPECT_FALSE(group.stats()[0].available_);
+  EXPECT_EQ(1u, group.acquire());
+  EXPECT_EQ(1u, group.acquire());
+}
+
+TEST(EndpointGroupTest, allOut) {
+  EndpointGroup::Options options;
+  options.failure_threshold_ = 1;
+  EndpointGroup group({"ws://a:8025/asr", "ws://b:8025/asr"}, options);
+
+  group.failed(1);
+  group.failed(0);
+  // the server due first is tried anyway
+  EXPECT_EQ(1u, group.acquire());
+}
+
+TEST(EndpointGroupTest, avoid) {
+  EndpointGroup group({"ws://a:8025/asr", "ws://b:8025/asr"});
+  for (int i = 0; i < 4; ++i) EXPECT_EQ(1u, group.acquire("", 0));
+
+  EndpointGroup single({"ws://a:8025/asr"});
+  EXPECT_EQ(0u, single.acquire("", 0));
+}
+
+TEST(EndpointGroupTest, hedgeDelay) {
+  EndpointGroup::Options options;
+  options.hedge_percentile_ = 90;
+  options.hedge_budget_ = 0.1;
+  EndpointGroup group(urls, options);
+
+  std::chrono::milliseconds delay;
+  for (int i = 1; i < 20; ++i) {
+    group.recordLatency(std::chrono::milliseconds(i * 10));
+    EXPECT_FALSE(group.hedgeDelay(delay));
+  }
+  group.recordLatency(std::chrono::milliseconds(200));
+  ASSERT_TRUE(group.hedgeDelay(delay));
+  EXPECT_EQ(std::chrono::milliseconds(190), delay);
+
+  // 20 recognitions so far, the budget allows 2 hedges
+  EXPECT_TRUE(group.takeHedge());
+  EXPECT_TRUE(group.takeHedge());
+  EXPECT_FALSE(group.takeHedge());
+  for (int i = 0; i < 10; ++i) group.hedgeDelay(delay);
+  EXPECT_TRUE(group.takeHedge());
+}
+
+TEST(EndpointGroupTest, hedgeDisabled) {
+  EndpointGroup group(urls);
+  for (int i = 0; i < 30; ++i)
+    group.recordLatency(std::chrono::milliseconds(10));
+  std::chrono::milliseconds delay;
+  EXPECT_FALSE(group.hedgeDelay(delay));
+  EXPECT_FALSE(group.takeHedge());
+}
+
+TEST(EndpointGroupTest, admissionDisabled) {
+  EndpointGroup group(urls);
+  for (int i = 0; i < 100; ++i) EXPECT_TRUE(group.admit(0));
+  EXPECT_EQ(100u, group.stats()[0].in_flight_);
+  EXPECT_EQ(0u, group.stats()[0].concurrency_limit_);
+}
+
+TEST(EndpointGroupTest, admissionLimit) {
+  EndpointGroup::Options options;
+  options.concurrency_limit_ = 2;
+  options.admission_wait_ = std::chrono::milliseconds(10);
+  EndpointGroup group(urls, options);
+
+  EXPECT_TRUE(group.admit(0));
+  EXPECT_TRUE(group.admit(0));
+  EXPECT_FALSE(group.admit(0));
+  EndpointGroup::Admission now;
+  now.wait_ = false;
+  EXPECT_FALSE(group.admit(0, now));
+  EXPECT_EQ(2u, group.stats()[0].rejections_);
+  // the limit is per server
+  EXPECT_TRUE(group.admit(1));
+}
+
+TEST(EndpointGroupTest, admissionWait) {
+  EndpointGroup::Options options;
+  options.concurrency_limit_ = 1;
+  options.admission_wait_ = std::chrono::milliseconds(1000);
+  EndpointGroup group(urls, options);
+
+  EXPECT_TRUE(group.admit(0));
+  // a slot freed while waiting is taken
+  std::thread complete([&group]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    group.complete(0, std::chrono::milliseconds(100), false);
+  });
+  EXPECT_TRUE(group.admit(0));
+  complete.join();
+}
+
+TEST(EndpointGroupTest, admissionAimd) {
+  EndpointGroup::Options options;
+  options.concurrency_limit_ = 4;
+  options.min_concurrency_ = 2;
+  options.max_concurrency_ = 5;
+  options.backoff_ratio_ = 0.5;
+  EndpointGroup group(urls, options);
+
+  // about limit results on time add one slot
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(group.admit(0));
+    group.complete(0, std::chrono::milliseconds(100), false);
+  }
+  EXPECT_EQ(5u, group.stats()[0].concurrency_limit_);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(group.admit(0));
+    group.complete(0, std::chrono::milliseconds(100), false);
+  }
+  EXPECT_EQ(5u, group.stats()[0].concurrency_limit_);
+
+  // a late result, then a failure
+  ASSERT_TRUE(group.admit(0));
+  group.complete(0, std::chrono::milliseconds(300), false);
+  EXPECT_EQ(2u, group.stats()[0].concurrency_limit_);
+  ASSERT_TRUE(group.admit(0));
+  group.complete(0, std::chrono::microseconds(0), true);
+  EXPECT_EQ(2u, group.stats()[0].concurrency_limit_);
+  EXPECT_EQ(0u, group.stats()[0].in_flight_);
+}
+
+TEST(EndpointGroupTest, admissionSlowSetup) {
+  EndpointGroup::Options options;
+  options.concurrency_limit_ = 4;
+  options.backoff_ratio_ = 0.5;
+  options.slow_setup_ = std::chrono::milliseconds(200);
+  EndpointGroup group(urls, options);
+
+  // the first setup is the usual one, setups within the tolerance keep it
+  group.succeeded(0, std::chrono::milliseconds(50));
+  group.succeeded(0, std::chrono::milliseconds(90));
+  EXPECT_EQ(4u, group.stats()[0].concurrency_limit_);
+
+  // beyond the tolerance, then beyond the slow setup time
+  group.succeeded(0, std::chrono::milliseconds(150));
+  EXPECT_EQ(2u, group.stats()[0].concurrency_limit_);
+  group.succeeded(1, std::chrono::milliseconds(300));
+  EXPECT_EQ(2u, group.stats()[1].concurrency_limit_);
+}
+
+TEST(EndpointGroupTest, admissionPriority) {
+  EndpointGroup::Options options;
+  options.concurrency_limit_ = 1;
+  options.admission_wait_ = std::chrono::milliseconds(5000);
+  EndpointGroup group(urls, options);
+
+  ASSERT_TRUE(group.admit(0));
+  std::vector<std::string> order;
+  {
+    AdmissionQueue queue(group);
+    queue.push("batch", admission(RecognitionPriority::BATCH, ""));
+    queue.push("normal", admission(RecognitionPriority::NORMAL, ""));
+    queue.push("live", admission(RecognitionPriority::LIVE, ""));
+    queue.push("normal2", admission(RecognitionPriority::NORMAL, ""));
+    EXPECT_EQ(4u, group.stats()[0].queued_);
+
+    // no cutting in line while others wait
+    EndpointGroup::Admission now;
+    now.wait_ = false;
+    EXPECT_FALSE(group.admit(0, now));
+    order = queue.drain();
+  }
+  EXPECT_EQ((std::vector<std::string>{"live", "normal", "normal2", "batch"}),
+            order);
+  EXPECT_EQ(0u, group.stats()[0].queued_);
+}
+
+TEST(EndpointGroupTest, admissionFairQueuing) {
+  EndpointGroup::Options options;
+  options.concurrency_limit_ = 1;
+  options.admission_wait_ = std::chrono::milliseconds(5000);
+  options.tenant_weights_["a"] = 2;
+  EndpointGroup group(urls, options);
+
+  ASSERT_TRUE(group.admit(0));
+  std::vector<std::string> order;
+  {
+    // a burst of tenant a does not hold b back, a gets twice the slots
+    AdmissionQueue queue(group);
+    for (int i = 1; i <= 4; ++i)
+      queue.push("a" + std::to_string(i),
+                 admission(RecognitionPriority::NORMAL, "a"));
+    queue.push("b1", admission(RecognitionPriority::NORMAL, "b"));
+    queue.push("b2", admission(RecognitionPriority::NORMAL, "b"));
+    order = queue.drain();
+  }
+  EXPECT_EQ((std::vector<std::string>{"a1", "a2", "b1", "a3", "a4", "b2"}),
+            order);
+}
+
+TEST(EndpointGroupTest, invalidTenantWeight) {
+  EndpointGroup::Options options;
+  options.tenant_weights_["a"] = 0;
+  EXPECT_THROW(EndpointGroup(urls, options), std::invalid_argument);
+}
+
+TEST(EndpointGroupTest, admissionQueueTimeout) {
+  EndpointGroup::Options options;
+  options.concurrency_limit_ = 1;
+  options.admission_wait_ = std::chrono::milliseconds(20);
+  EndpointGroup group(urls, options);
+
+  ASSERT_TRUE(group.admit(0));
+  EXPECT_FALSE(group.admit(0, admission(RecognitionPriority::LIVE, "a")));
+  EXPECT_EQ(0u, group.stats()[0].queued_);
+  EXPECT_EQ(1u, group.stats()[0].rejections_);
+}
@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#include <gtest/gtest.h>
+
+#include <sys/types.h>
+#include <utime.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <cpqd/asr-client/language_model_registry.h>
+#include <cpqd/asr-client/recognition_exception.h>
+
+#include "src/asr_message_request.h"
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+namespace {
+
+void writeGrammar(const std::string& path, const std::string& body,
+                  time_t mtime) {
+  std::ofstream ofs(path, std::ofstream::binary | std::ofstream::trunc);
+  ofs << body;
+  ofs.close();
+
+  struct utimbuf times;
+  times.actime = mtime;
+  times.modtime = mtime;
+  utime(path.c_str(), &times);
+}
+
+}  // namespace
+
+TEST(LanguageModelRegistryTest, sharedAndReloaded) {
+  std::string path = testing::TempDir() + "registry_test.gram";
+  writeGrammar(path, "#ABNF 1.0;\nroot $a;\n$a = sim;", 1000);
+
+  LanguageModelRegistry registry;
+  registry.setReloadCheckInterval(std::chrono::milliseconds(0));
+  registry.addGrammarFile("yes", path);
+
+  std::shared_ptr<const LanguageModelList> first = registry.get("yes");
+  EXPECT_EQ("#ABNF 1.0;\nroot $a;\n$a = sim;", first->getGrammarBody());
+  EXPECT_EQ(first, registry.get("yes"));
+
+  // modified file, running recognitions keep the previous model
+  writeGrammar(path, "#ABNF 1.0;\nroot $a;\n$a = sim | claro;", 2000);
+  std::shared_ptr<const LanguageModelList> second = registry.get("yes");
+  EXPECT_NE(first, second);
+  EXPECT_EQ("#ABNF 1.0;\nroot $a;\n$a = sim;", first->getGrammarBody());
+  EXPECT_EQ("#ABNF 1.0;\nroot $a;\n$a = sim | claro;",
+            second->getGrammarBody());
+
+  // a file that can't be read keeps the last version
+  std::remove(path.c_str());
+  EXPECT_EQ(second, registry.get("yes"));
+
+  registry.remove("yes");
+  EXPECT_THROW(registry.get("yes"), RecognitionException);
+  EXPECT_THROW(registry.addGrammarFile("no", path), RecognitionException);
+}
+
+TEST(LanguageModelRegistryTest, startRecognitionFramedOnce) {
+  LanguageModelRegistry registry;
+  registry.addFromURI("slm", "builtin:slm/general");
+
+  std::shared_ptr<const LanguageModelList> lm = registry.get("slm");
+  std::shared_ptr<const std::string> message =
+      ASRMessageRequest::startRecognition(*lm);
+  EXPECT_EQ("ASR 2.4 START_RECOGNITION\r\n"
+            "Accept:application/json\r\n"
+            "Content-Length:19\r\n"
+            "Content-Type:text/uri-list\r\n\r\n"
+            "builtin:slm/general\r\n", *message);
+  EXPECT_EQ(message, ASRMessageRequest::startRecognition(*registry.get("slm")));
+
+  registry.addInlineGrammar("menu", "#ABNF 1.0;");
+  EXPECT_EQ("ASR 2.4 START_RECOGNITION\r\n"
+            "Accept:application/json\r\n"
+            "Content-ID:gram\r\n"
+            "Content-Length:10\r\n"
+            "Content-Type:application/srgs\r\n\r\n"
+            "#ABNF 1.0;\r\n",
+            *ASRMessageRequest::startRecognition(*registry.get("menu")));
+}
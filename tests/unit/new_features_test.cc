@@ -78,9 +78,9 @@ TEST(RecognizerTest, wordsSlm) {
     if(res.getCode() != RecognitionResult::Code::RECOGNIZED) continue;
     at_least_one_high_confidence = true;
 
-    for (RecognitionResult::Alternative& alt : res.getAlternatives()) {
+    for (const RecognitionResult::Alternative& alt : res.getAlternatives()) {
       ASSERT_GE(alt.getConfidence(), 90);
-      auto words = alt.getWords();
+      const auto& words = alt.getWords();
       ASSERT_EQ(6, words.size());
       EXPECT_EQ("previsão", words[0].text_);
       EXPECT_EQ("do", words[1].text_);
@@ -119,10 +119,10 @@ TEST(RecognizerTest, wordsGrammar) {
     if(res.getCode() != RecognitionResult::Code::RECOGNIZED) continue;
     at_least_one_high_confidence = true;
 
-    for (RecognitionResult::Alternative& alt : res.getAlternatives()) {
+    for (const RecognitionResult::Alternative& alt : res.getAlternatives()) {
       std::cout << "alt.getConfidence(): " << alt.getConfidence() << std::endl;
       ASSERT_GE(alt.getConfidence(), 90);
-      auto words = alt.getWords();
+      const auto& words = alt.getWords();
       ASSERT_EQ(8, words.size());
       EXPECT_EQ("dezenove", words[0].text_);
       EXPECT_EQ("três", words[1].text_);
@@ -174,7 +174,7 @@ TEST(RecognizerTest, dynamicGrammarMulti) {
     ASSERT_LE(abs(end_times[num_res] - res.endTime()), .6) << "End time deviated more than 300ms!";
     num_res++;
 
-    for (RecognitionResult::Alternative& alt : res.getAlternatives()) {
+    for (const RecognitionResult::Alternative& alt : res.getAlternatives()) {
       std::cout << "alt.getConfidence(): " << alt.getConfidence() << std::endl;
       std::cout << alt.getText() << std::endl;
     }
@@ -0,0 +1,133 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cpqd/asr-client/buffer_audio_source.h>
+
+#include "src/outbound_scheduler.h"
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+class OutboundSchedulerTest : public ::testing::Test {
+ protected:
+  OutboundSchedulerTest()
+      : scheduler_(
+            [this](const std::string& message) {
+              std::unique_lock<std::mutex> lk(lock_);
+              sent_.push_back(message);
+              buffered_ += message.size();
+            },
+            [this]() { return buffered_.load(); }) {
+    scheduler_.setAudioHighWater(8);
+  }
+
+  std::mutex lock_;
+  std::vector<std::string> sent_;
+  std::atomic<size_t> buffered_{0};
+  OutboundScheduler scheduler_;
+};
+
+TEST_F(OutboundSchedulerTest, controlAheadOfAudio) {
+  std::string audio(8, 'a');
+  ASSERT_TRUE(scheduler_.sendAudio(audio));
+
+  // the connection is above the mark, the next audio waits
+  std::atomic<bool> sent{false};
+  std::thread audio_thread([this, &sent]() {
+    std::string more(8, 'b');
+    sent = scheduler_.sendAudio(more);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(sent);
+
+  std::string control = "CANCEL";
+  scheduler_.sendControl(control);
+  {
+    std::unique_lock<std::mutex> lk(lock_);
+    ASSERT_EQ(2, sent_.size());
+    EXPECT_EQ("CANCEL", sent_[1]);
+  }
+
+  // the connection drains, audio goes out
+  buffered_ = 0;
+  audio_thread.join();
+  EXPECT_TRUE(sent);
+
+  RecognizerMetrics metrics;
+  scheduler_.metrics(metrics);
+  EXPECT_EQ(1, metrics.control_messages_);
+  EXPECT_EQ(2, metrics.audio_messages_);
+  EXPECT_EQ(1, metrics.audio_stalls_);
+  EXPECT_GE(metrics.audio_stall_time_, std::chrono::milliseconds(20));
+  EXPECT_EQ(8, metrics.send_max_buffered_);
+}
+
+TEST_F(OutboundSchedulerTest, discardWakesAudio) {
+  buffered_ = 100;
+  std::atomic<bool> done{false};
+  bool sent = true;
+  std::thread audio_thread([this, &done, &sent]() {
+    std::string audio(8, 'a');
+    sent = scheduler_.sendAudio(audio);
+    done = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(done);
+
+  scheduler_.discardAudio();
+  audio_thread.join();
+  EXPECT_FALSE(sent);
+
+  std::string audio(1, 'a');
+  buffered_ = 0;
+  EXPECT_FALSE(scheduler_.sendAudio(audio));
+  scheduler_.resumeAudio();
+  EXPECT_TRUE(scheduler_.sendAudio(audio));
+}
+
+TEST(BufferAudioSourceTest, writeWaitsForReader) {
+  AudioFormat fmt;
+  BufferAudioSource audio(fmt, 9);
+  std::vector<char> block(8, 'a');
+
+  // a full buffer refuses audio instead of growing
+  EXPECT_TRUE(audio.write(block));
+  EXPECT_EQ(0, audio.writeAvailable());
+  EXPECT_FALSE(audio.write(block.data(), block.size(),
+                           std::chrono::milliseconds(10)));
+
+  std::thread reader([&audio]() {
+    std::vector<char> buffer;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    audio.read(buffer);
+  });
+  EXPECT_TRUE(audio.write(block.data(), block.size(),
+                          std::chrono::seconds(5)));
+  reader.join();
+
+  audio.finish();
+  EXPECT_FALSE(audio.write(block.data(), 1, std::chrono::seconds(5)));
+}
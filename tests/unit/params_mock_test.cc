@@ -99,10 +99,39 @@ class RecognizerMockTest : public testing::Test, public testing::WithParamInterf
             .build();
     }
 
-   private:
+   protected:
     std::string url_ = "";
 };
 
+/* The mock server drops the connection during the audio, then refuses the
+ * first reconnection */
+class ReplayMockTest : public RecognizerMockTest {
+   public:
+    void SetUp() {
+        setenv("DROP_ONCE", "1", true);
+        RecognizerMockTest::SetUp();
+    }
+
+    void TearDown() {
+        RecognizerMockTest::TearDown();
+        unsetenv("DROP_ONCE");
+    }
+};
+
+/* The mock server never answers a ping */
+class KeepAliveMockTest : public RecognizerMockTest {
+   public:
+    void SetUp() {
+        setenv("NO_PONG", "1", true);
+        RecognizerMockTest::SetUp();
+    }
+
+    void TearDown() {
+        RecognizerMockTest::TearDown();
+        unsetenv("NO_PONG");
+    }
+};
+
 TEST_P(RecognizerMockTest, params) {
     setenv("ACCOUNT_TAG", "other-tag", true);
     setenv("CHANNEL_IDENTIFIER", "my-channel-1", true);
@@ -171,4 +200,59 @@ TEST_P(RecognizerMockTest, params) {
     EXPECT_TRUE(VerifyMessage("/tmp/message", messages));
 }
 
-INSTANTIATE_TEST_CASE_P(, RecognizerMockTest, testing::Values(test::mock_url, test::tls_mock_url));
\ No newline at end of file
+INSTANTIATE_TEST_CASE_P(, RecognizerMockTest, testing::Values(test::mock_url, test::tls_mock_url));
+
+TEST_P(KeepAliveMockTest, missedPong) {
+    // the audio never ends, only the keepalive can end the recognition
+    std::shared_ptr<BufferAudioSource> audio = std::make_shared<BufferAudioSource>();
+    std::unique_ptr<LanguageModelList> lm =
+        LanguageModelList::Builder().addFromURI(test::slm_uri).build();
+    std::unique_ptr<SpeechRecognizer> asr = SpeechRecognizer::Builder()
+                                                .serverUrl(url_)
+                                                .credentials(test::username, test::password)
+                                                .keepAlive(200, 200)
+                                                .maxWaitSeconds(10)
+                                                .build();
+
+    asr->recognize(audio, std::move(lm));
+    try {
+        asr->waitRecognitionResult();
+        FAIL() << "Expected the dead connection to fail the recognition";
+    } catch (RecognitionException& e) {
+        EXPECT_EQ(RecognitionError::Code::CONNECTION_FAILURE, e.getCode());
+    }
+    audio->finish();
+
+    RecognizerMetrics metrics = asr->getMetrics();
+    EXPECT_LE(1u, metrics.pings_);
+    EXPECT_EQ(1u, metrics.connections_lost_);
+    asr->close();
+}
+
+INSTANTIATE_TEST_CASE_P(, KeepAliveMockTest, testing::Values(test::mock_url, test::tls_mock_url));
+
+TEST_P(ReplayMockTest, replayAfterRefusedReconnect) {
+    std::shared_ptr<AudioSource> audio = std::make_shared<FileAudioSource>(test::previsao_tempo_8k);
+    std::unique_ptr<LanguageModelList> lm =
+        LanguageModelList::Builder().addFromURI(test::slm_uri).build();
+    std::unique_ptr<SpeechRecognizer> asr = SpeechRecognizer::Builder()
+                                                .serverUrl(url_)
+                                                .credentials(test::username, test::password)
+                                                .replayOnConnectionLoss(3, 1 << 20)
+                                                .maxWaitSeconds(30)
+                                                .build();
+
+    // the refused attempt is retried, the application only sees the result
+    asr->recognize(audio, std::move(lm));
+    std::vector<RecognitionResult> result = asr->waitRecognitionResult();
+    ASSERT_LT(0, result.size());
+    EXPECT_EQ(RecognitionResult::Code::RECOGNIZED, result.back().getCode());
+
+    RecognizerMetrics metrics = asr->getMetrics();
+    EXPECT_EQ(1u, metrics.connections_lost_);
+    EXPECT_EQ(1u, metrics.replays_);
+    EXPECT_EQ(3u, metrics.connections_);
+    asr->close();
+}
+
+INSTANTIATE_TEST_CASE_P(, ReplayMockTest, testing::Values(test::mock_url, test::tls_mock_url));
@@ -0,0 +1,148 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "src/partial_coalescer.h"
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+namespace {
+
+PartialCoalescer::Pending partial(const std::string& body) {
+  PartialCoalescer::Pending pending;
+  pending.body_ = std::make_shared<const std::string>(body);
+  return pending;
+}
+
+PartialRecognition text(const std::string& text, int segment = 0) {
+  PartialRecognition partial;
+  partial.text_ = text;
+  partial.speech_segment_index_ = segment;
+  return partial;
+}
+
+}  // namespace
+
+TEST(PartialCoalescerTest, latestWins) {
+  typedef PartialCoalescer::Clock Clock;
+  PartialCoalescer coalescer;
+  coalescer.configure(std::chrono::milliseconds(200), 0);
+  std::chrono::milliseconds wait;
+  PartialCoalescer::Pending taken;
+  Clock::time_point t0 = Clock::now();
+
+  // the first partial goes through
+  ASSERT_TRUE(coalescer.offer(partial("a"), t0, wait));
+  ASSERT_TRUE(coalescer.take(t0, taken));
+  EXPECT_EQ("a", *taken.body_);
+
+  // the next ones are held and a single timer is armed
+  EXPECT_FALSE(coalescer.offer(partial("b"), t0 + std::chrono::milliseconds(50),
+                               wait));
+  EXPECT_EQ(150, wait.count());
+  EXPECT_FALSE(coalescer.offer(partial("c"), t0 + std::chrono::milliseconds(90),
+                               wait));
+  EXPECT_EQ(0, wait.count());
+
+  ASSERT_TRUE(coalescer.onTimer(t0 + std::chrono::milliseconds(200)));
+  ASSERT_TRUE(coalescer.take(t0 + std::chrono::milliseconds(200), taken));
+  EXPECT_EQ("c", *taken.body_);
+  EXPECT_FALSE(coalescer.take(t0 + std::chrono::milliseconds(200), taken));
+
+  RecognizerMetrics metrics;
+  coalescer.metrics(metrics);
+  EXPECT_EQ(3, metrics.partials_received_);
+  EXPECT_EQ(1, metrics.partials_skipped_);
+}
+
+TEST(PartialCoalescerTest, resetDropsPending) {
+  typedef PartialCoalescer::Clock Clock;
+  PartialCoalescer coalescer;
+  coalescer.configure(std::chrono::milliseconds(200), 0);
+  std::chrono::milliseconds wait;
+  PartialCoalescer::Pending taken;
+  Clock::time_point t0 = Clock::now();
+
+  ASSERT_TRUE(coalescer.offer(partial("a"), t0, wait));
+  ASSERT_TRUE(coalescer.take(t0, taken));
+  EXPECT_FALSE(coalescer.offer(partial("b"), t0, wait));
+  coalescer.reset();
+  EXPECT_FALSE(coalescer.onTimer(t0 + std::chrono::milliseconds(200)));
+
+  // a new segment starts without delay
+  EXPECT_TRUE(coalescer.offer(partial("c"), t0, wait));
+}
+
+TEST(PartialCoalescerTest, minTextDelta) {
+  PartialCoalescer coalescer;
+  coalescer.configure(std::chrono::milliseconds(0), 3);
+  EXPECT_TRUE(coalescer.filtersText());
+
+  PartialRecognition p1 = text("previsão");
+  PartialRecognition p2 = text("previsão d");
+  PartialRecognition p3 = text("previsão do ");
+  PartialRecognition p4 = text("previsão do t");
+  EXPECT_TRUE(coalescer.accept(p1));
+  EXPECT_FALSE(coalescer.accept(p2));
+  EXPECT_TRUE(coalescer.accept(p3));
+  EXPECT_FALSE(coalescer.accept(p4));
+}
+
+TEST(PartialCoalescerTest, partialDelta) {
+  PartialCoalescer coalescer;
+
+  PartialRecognition p1 = text("previsão");
+  ASSERT_TRUE(coalescer.accept(p1));
+  EXPECT_EQ(0, p1.stable_prefix_length_);
+  EXPECT_EQ("previsão", p1.changed_suffix_);
+
+  PartialRecognition p2 = text("previsão do tempo");
+  ASSERT_TRUE(coalescer.accept(p2));
+  EXPECT_EQ(std::string("previsão").size(), p2.stable_prefix_length_);
+  EXPECT_EQ(" do tempo", p2.changed_suffix_);
+
+  // the hypothesis changed in the middle of a two byte code point
+  PartialRecognition p3 = text("previsâo");
+  ASSERT_TRUE(coalescer.accept(p3));
+  EXPECT_EQ(std::string("previs").size(), p3.stable_prefix_length_);
+  EXPECT_EQ("âo", p3.changed_suffix_);
+
+  // a new segment starts from scratch
+  PartialRecognition p4 = text("previsão", 1);
+  ASSERT_TRUE(coalescer.accept(p4));
+  EXPECT_EQ(0, p4.stable_prefix_length_);
+
+  coalescer.reset();
+  PartialRecognition p5 = text("previsão", 1);
+  ASSERT_TRUE(coalescer.accept(p5));
+  EXPECT_EQ(0, p5.stable_prefix_length_);
+}
+
+TEST(PartialCoalescerTest, textDelta) {
+  EXPECT_EQ(0, PartialCoalescer::textDelta("abc", "abc"));
+  EXPECT_EQ(1, PartialCoalescer::textDelta("abc", "abd"));
+  EXPECT_EQ(2, PartialCoalescer::textDelta("", "ab"));
+  // "ã" and "â" share their first byte, they still count as one code point
+  EXPECT_EQ(1, PartialCoalescer::textDelta("ã", "â"));
+  EXPECT_EQ(1, PartialCoalescer::textDelta("não", "nãoé"));
+}
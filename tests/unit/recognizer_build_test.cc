@@ -37,23 +37,23 @@ public:
 
   void onSpeechStop(int time) { std::cout << "speech stop..." << std::endl; }
 
-  void onPartialRecognition(PartialRecognition& partial){
+  void onPartialRecognition(const PartialRecognition& partial){
     std::cout << partial.text_ << std::endl;
   }
 
-  void onRecognitionResult(RecognitionResult& res) {
+  void onRecognitionResult(const RecognitionResult& res) {
     if (res.getCode() == RecognitionResult::Code::NO_MATCH) {
       std::cout << "NO_MATCH" << std::endl;
       return;
     }
 
     int i = 0;
-    for (RecognitionResult::Alternative& alt : res.getAlternatives()) {
+    for (const RecognitionResult::Alternative& alt : res.getAlternatives()) {
       std::cout << "Alternativa [" << ++i
                 << "] (score = " << alt.getConfidence()
                 << "): " << alt.getText() << std::endl;
       int j = 0;
-      for (Interpretation& interpretation : alt.getInterpretations()) {
+      for (const Interpretation& interpretation : alt.getInterpretations()) {
         std::cout << "\t Interpretacao [" << ++j
                   << "]: " << interpretation.text_ << std::endl;
       }
@@ -85,6 +85,23 @@ TEST(RecognizerBuildTest, urlInexistent) {
                RecognitionException);
 }
 
+TEST(RecognizerBuildTest, keepAliveWithoutPongTimeout) {
+  ASSERT_THROW(SpeechRecognizer::Builder().keepAlive(1000, 0),
+               std::invalid_argument);
+  ASSERT_NO_THROW(SpeechRecognizer::Builder().keepAlive(0, 0));
+}
+
+TEST(RecognizerBuildTest, emptyEndpointGroup) {
+  ASSERT_THROW(SpeechRecognizer::Builder().endpoints(nullptr),
+               std::invalid_argument);
+}
+
+TEST(RecognizerBuildTest, replayWithoutWindow) {
+  ASSERT_THROW(SpeechRecognizer::Builder().replayOnConnectionLoss(3, 0),
+               std::invalid_argument);
+  ASSERT_NO_THROW(SpeechRecognizer::Builder().replayOnConnectionLoss(0, 0));
+}
+
 
 TEST(RecognizerBuildTest, addListener) {
   std::unique_ptr<RecognitionConfig> config =
@@ -0,0 +1,50 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "src/reconnect_backoff.h"
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+TEST(ReconnectBackoffTest, boundDoublesUpToCap) {
+  ReconnectBackoff backoff;
+  backoff.configure(std::chrono::milliseconds(100),
+                    std::chrono::milliseconds(1000));
+
+  EXPECT_EQ(std::chrono::milliseconds(100), backoff.bound(0));
+  EXPECT_EQ(std::chrono::milliseconds(200), backoff.bound(1));
+  EXPECT_EQ(std::chrono::milliseconds(800), backoff.bound(3));
+  EXPECT_EQ(std::chrono::milliseconds(1000), backoff.bound(4));
+  EXPECT_EQ(std::chrono::milliseconds(1000), backoff.bound(1000));
+}
+
+TEST(ReconnectBackoffTest, delayIsJittered) {
+  ReconnectBackoff backoff;
+  bool varies = false;
+  std::chrono::milliseconds first = backoff.delay(5);
+  for (int i = 0; i < 100; ++i) {
+    std::chrono::milliseconds delay = backoff.delay(5);
+    EXPECT_LE(std::chrono::milliseconds(0), delay);
+    EXPECT_GE(backoff.bound(5), delay);
+    varies = varies || delay != first;
+  }
+  EXPECT_TRUE(varies);
+}
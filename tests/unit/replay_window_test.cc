@@ -0,0 +1,86 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/replay_window.h"
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+TEST(ReplayWindowTest, disabled) {
+  ReplayWindow window;
+  window.append("abc", 3);
+  EXPECT_FALSE(window.replayable());
+  EXPECT_EQ(0, window.size());
+}
+
+TEST(ReplayWindowTest, replayFromLastSegment) {
+  ReplayWindow window;
+  window.configure(100);
+  window.append("0123456789", 10);
+
+  // the first 4 bytes were recognized as a segment
+  window.trim(4);
+  EXPECT_EQ(6, window.size());
+
+  bool finished;
+  EXPECT_EQ("456789", window.restart(finished));
+  EXPECT_FALSE(finished);
+
+  // the new session counts from the start of the replayed audio
+  window.append("ab", 2);
+  window.finish();
+  window.trim(3);
+  EXPECT_EQ("789ab", window.restart(finished));
+  EXPECT_TRUE(finished);
+
+  // offsets before the window are already gone
+  window.trim(0);
+  EXPECT_EQ(5, window.size());
+}
+
+TEST(ReplayWindowTest, overflow) {
+  ReplayWindow window;
+  window.configure(8);
+  window.append("01234", 5);
+  EXPECT_TRUE(window.replayable());
+  window.append("56789", 5);
+  EXPECT_FALSE(window.replayable());
+  EXPECT_EQ(0, window.size());
+
+  window.reset();
+  EXPECT_TRUE(window.replayable());
+}
+
+TEST(ReplayWindowTest, snapshotKeepsSession) {
+  ReplayWindow window;
+  window.configure(100);
+  window.append("0123456789", 10);
+  window.trim(4);
+  window.finish();
+
+  bool finished;
+  EXPECT_EQ("456789", window.snapshot(finished));
+  EXPECT_TRUE(finished);
+
+  // offsets still count from the start of the current session
+  window.trim(6);
+  EXPECT_EQ("6789", window.snapshot(finished));
+}
@@ -0,0 +1,180 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include <cpqd/asr-client/recognition_result.h>
+
+#include "src/asr_result_decoder.h"
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+const std::string final_body =
+    "{\"alternatives\": [{\"text\": \"previs\\u00e3o do tempo\", "
+    "\"score\": 97, \"interpretations\": [\"previsao\", {\"a\": [1, 2]}], "
+    "\"words\": [{\"text\": \"previsão\", \"score\": 95, "
+    "\"start_time\": 0.5, \"end_time\": 1.25}, {\"text\": \"do\", "
+    "\"score\": 99, \"start_time\": 1.25, \"end_time\": 1.5e0}]}, "
+    "{\"text\": \"previsão de tempo\", \"score\": 40}], "
+    "\"age_scores\": {\"age\": 31, \"p\": [0.1]}, "
+    "\"emotion_scores\": {\"emotion\": \"neutral\"}, "
+    "\"gender_scores\": {}, "
+    "\"segment_index\": 2, \"last_segment\": false, \"final_result\": true, "
+    "\"start_time\": 0.4, \"end_time\": 1.6, "
+    "\"result_status\": \"RECOGNIZED\"}";
+
+TEST(ResultDecoderTest, finalResult) {
+  ASRResultDecoder decoder;
+  ASRResultDecoder::Routing routing;
+  RecognitionResult res;
+
+  ASSERT_TRUE(decoder.decode(final_body, routing, res));
+  EXPECT_TRUE(routing.has_final_result);
+  EXPECT_TRUE(routing.final_result);
+  EXPECT_FALSE(routing.last_segment);
+  EXPECT_EQ(2, routing.segment_index);
+
+  EXPECT_EQ(RecognitionResult::Code::RECOGNIZED, res.getCode());
+  EXPECT_FALSE(res.isLastSpeechSegment());
+  EXPECT_FLOAT_EQ(0.4, res.startTime());
+  EXPECT_FLOAT_EQ(1.6, res.endTime());
+
+  const std::vector<RecognitionResult::Alternative>& alts = res.getAlternatives();
+  ASSERT_EQ(2, alts.size());
+  EXPECT_EQ("previsão do tempo", alts[0].getText());
+  EXPECT_EQ(97, alts[0].getConfidence());
+  const std::vector<Interpretation>& interps = alts[0].getInterpretations();
+  ASSERT_EQ(2, interps.size());
+  EXPECT_EQ("previsao", interps[0].text_);
+  EXPECT_EQ("{\"a\": [1, 2]}", interps[1].text_);
+
+  const std::vector<Word>& words = alts[0].getWords();
+  ASSERT_EQ(2, words.size());
+  EXPECT_EQ("previsão", words[0].text_);
+  EXPECT_EQ(95, words[0].confidence_);
+  EXPECT_FLOAT_EQ(0.5, words[0].start_time_);
+  EXPECT_FLOAT_EQ(1.5, words[1].end_time_);
+  EXPECT_EQ(40, alts[1].getConfidence());
+
+  EXPECT_EQ(std::to_string(31.0), res.getClassifiers().getAge());
+  EXPECT_EQ("neutral", res.getClassifiers().getEmotion());
+  EXPECT_FALSE(res.getClassifiers().hasGender());
+}
+
+TEST(ResultDecoderTest, skipWords) {
+  ASRResultDecoder::Options options;
+  options.words = false;
+  options.interpretations = false;
+  ASRResultDecoder decoder(options);
+  ASRResultDecoder::Routing routing;
+  RecognitionResult res;
+
+  ASSERT_TRUE(decoder.decode(final_body, routing, res));
+  const std::vector<RecognitionResult::Alternative>& alts = res.getAlternatives();
+  ASSERT_EQ(2, alts.size());
+  EXPECT_EQ("previsão do tempo", alts[0].getText());
+  EXPECT_TRUE(alts[0].getWords().empty());
+  EXPECT_TRUE(alts[0].getInterpretations().empty());
+}
+
+TEST(ResultDecoderTest, partialResult) {
+  ASRResultDecoder decoder;
+  ASRResultDecoder::Routing routing;
+  PartialRecognition partial;
+
+  std::string body =
+      "{\"alternatives\": [{\"words\": [], \"text\": \"previsão\"}], "
+      "\"segment_index\": 1, \"final_result\": false}";
+  ASSERT_TRUE(decoder.decodePartial(body, routing, partial));
+  EXPECT_FALSE(routing.final_result);
+  EXPECT_EQ("previsão", partial.text_);
+  EXPECT_EQ(1, partial.speech_segment_index_);
+}
+
+TEST(ResultDecoderTest, scanRouting) {
+  ASRResultDecoder decoder;
+  ASRResultDecoder::Routing routing;
+
+  ASSERT_TRUE(decoder.scan(final_body, routing));
+  EXPECT_TRUE(routing.final_result);
+  EXPECT_EQ("RECOGNIZED", routing.result_status);
+  EXPECT_EQ(2, routing.segment_index);
+}
+
+TEST(ResultDecoderTest, statusWithoutAlternatives) {
+  ASRResultDecoder decoder;
+  ASRResultDecoder::Routing routing;
+  RecognitionResult res;
+
+  ASSERT_TRUE(decoder.decode("{\"result_status\": \"NO_SPEECH\"}", routing,
+                             res));
+  EXPECT_EQ(RecognitionResult::Code::NO_SPEECH, res.getCode());
+  EXPECT_TRUE(res.isLastSpeechSegment());
+}
+
+TEST(ResultDecoderTest, malformedBody) {
+  ASRResultDecoder decoder;
+  ASRResultDecoder::Routing routing;
+  RecognitionResult res;
+
+  EXPECT_FALSE(decoder.decode("", routing, res));
+  EXPECT_FALSE(decoder.decode("{\"alternatives\": [{\"text\": \"a}]}",
+                              routing, res));
+  EXPECT_FALSE(decoder.decode("{\"final_result\": tru}", routing, res));
+}
+
+TEST(ResultDecoderTest, integerOutOfRange) {
+  ASRResultDecoder decoder;
+  ASRResultDecoder::Routing routing;
+  RecognitionResult res;
+
+  EXPECT_FALSE(decoder.decode("{\"segment_index\": 1e20}", routing, res));
+  EXPECT_FALSE(decoder.scan("{\"segment_index\": -3000000000}", routing));
+  EXPECT_FALSE(decoder.decode(
+      "{\"alternatives\": [{\"text\": \"a\", \"score\": 9.5}]}", routing,
+      res));
+  EXPECT_FALSE(decoder.decode(
+      "{\"alternatives\": [{\"words\": [{\"score\": 1e300}]}]}", routing,
+      res));
+  EXPECT_TRUE(decoder.decode("{\"segment_index\": 3.0}", routing, res));
+  EXPECT_EQ(3, routing.segment_index);
+}
+
+TEST(ResultDecoderTest, rawResultMaterialize) {
+  std::shared_ptr<const std::string> body =
+      std::make_shared<const std::string>(final_body);
+  RawRecognitionResult raw(body, RecognitionResult::Code::RECOGNIZED, true, 2,
+                           false);
+
+  EXPECT_EQ(body.get(), &raw.getBody());
+  EXPECT_TRUE(raw.isFinal());
+
+  RecognitionResult res = raw.materialize();
+  EXPECT_EQ(RecognitionResult::Code::RECOGNIZED, res.getCode());
+  EXPECT_FALSE(res.isLastSpeechSegment());
+  ASSERT_EQ(2, res.getAlternatives().size());
+  EXPECT_EQ("previsão do tempo", res.getAlternatives()[0].getText());
+
+  RawRecognitionResult empty(nullptr, RecognitionResult::Code::NO_SPEECH,
+                             true, 0, true);
+  EXPECT_TRUE(empty.getBody().empty());
+  EXPECT_EQ(RecognitionResult::Code::NO_SPEECH, empty.materialize().getCode());
+}
@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/bounded_queue.h"
+#include "src/result_queue.h"
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+namespace {
+
+ResultQueue::Entry entry(RecognitionResult::Code code) {
+  return {std::make_shared<RecognitionResult>(code), nullptr};
+}
+
+}  // namespace
+
+TEST(ResultQueueTest, boundedQueue) {
+  BoundedQueue<int> queue(3);
+  EXPECT_EQ(4, queue.capacity());
+
+  for (int i = 0; i < 4; ++i) EXPECT_TRUE(queue.push(std::move(i)));
+  int value = 10;
+  EXPECT_FALSE(queue.push(std::move(value)));
+  EXPECT_EQ(4, queue.size());
+
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(queue.pop(value));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(ResultQueueTest, boundedQueueThreads) {
+  BoundedQueue<int> queue(64);
+  const int count = 100000;
+  std::atomic<long> sum{0};
+
+  std::thread consumer([&queue, &sum]() {
+    int received = 0;
+    int value;
+    int last = -1;
+    while (received < count) {
+      if (!queue.pop(value)) continue;
+      // single producer, order is preserved
+      EXPECT_EQ(last + 1, value);
+      last = value;
+      sum += value;
+      ++received;
+    }
+  });
+  for (int i = 0; i < count; ++i) {
+    int value = i;
+    while (!queue.push(std::move(value))) std::this_thread::yield();
+  }
+  consumer.join();
+
+  EXPECT_EQ(static_cast<long>(count) * (count - 1) / 2, sum);
+}
+
+TEST(ResultQueueTest, dropOldest) {
+  ResultQueue queue(2, ResultOverflow::DROP_OLDEST);
+  EXPECT_TRUE(queue.push(entry(RecognitionResult::Code::NO_MATCH)));
+  EXPECT_TRUE(queue.push(entry(RecognitionResult::Code::NO_SPEECH)));
+  EXPECT_TRUE(queue.push(entry(RecognitionResult::Code::MAX_SPEECH)));
+
+  RecognitionResult res;
+  ASSERT_TRUE(queue.pop(res));
+  EXPECT_EQ(RecognitionResult::Code::NO_SPEECH, res.getCode());
+  ASSERT_TRUE(queue.pop(res));
+  EXPECT_EQ(RecognitionResult::Code::MAX_SPEECH, res.getCode());
+  EXPECT_FALSE(queue.pop(res));
+
+  RecognizerMetrics metrics;
+  queue.metrics(metrics);
+  EXPECT_EQ(1, metrics.results_dropped_);
+  EXPECT_EQ(0, metrics.result_queue_depth_);
+}
+
+TEST(ResultQueueTest, configuredCapacity) {
+  // not a power of two
+  ResultQueue queue(3, ResultOverflow::FAIL);
+  EXPECT_TRUE(queue.push(entry(RecognitionResult::Code::NO_MATCH)));
+  EXPECT_TRUE(queue.push(entry(RecognitionResult::Code::NO_SPEECH)));
+  EXPECT_TRUE(queue.push(entry(RecognitionResult::Code::MAX_SPEECH)));
+  EXPECT_FALSE(queue.push(entry(RecognitionResult::Code::NO_INPUT_TIMEOUT)));
+
+  RecognizerMetrics metrics;
+  queue.metrics(metrics);
+  EXPECT_EQ(3, metrics.result_queue_depth_);
+  EXPECT_EQ(1, metrics.results_dropped_);
+}
+
+TEST(ResultQueueTest, dropNewestAndFail) {
+  ResultQueue newest(2, ResultOverflow::DROP_NEWEST);
+  EXPECT_TRUE(newest.push(entry(RecognitionResult::Code::NO_MATCH)));
+  EXPECT_TRUE(newest.push(entry(RecognitionResult::Code::NO_SPEECH)));
+  EXPECT_TRUE(newest.push(entry(RecognitionResult::Code::MAX_SPEECH)));
+
+  RecognitionResult res;
+  ASSERT_TRUE(newest.pop(res));
+  EXPECT_EQ(RecognitionResult::Code::NO_MATCH, res.getCode());
+
+  ResultQueue fail(2, ResultOverflow::FAIL);
+  EXPECT_TRUE(fail.push(entry(RecognitionResult::Code::NO_MATCH)));
+  EXPECT_TRUE(fail.push(entry(RecognitionResult::Code::NO_SPEECH)));
+  EXPECT_FALSE(fail.push(entry(RecognitionResult::Code::MAX_SPEECH)));
+}
+
+TEST(ResultQueueTest, rawEntry) {
+  ResultQueue queue;
+  std::shared_ptr<const RawRecognitionResult> raw =
+      std::make_shared<const RawRecognitionResult>(
+          std::make_shared<const std::string>(
+              "{\"alternatives\": [{\"text\": \"um\", \"score\": 90}]}"),
+          RecognitionResult::Code::RECOGNIZED, true, 0, true);
+  EXPECT_TRUE(queue.push({nullptr, raw}));
+
+  RecognitionResult res;
+  ASSERT_TRUE(queue.pop(res));
+  ASSERT_EQ(1, res.getAlternatives().size());
+  EXPECT_EQ("um", res.getAlternatives()[0].getText());
+}
+
+TEST(ResultQueueTest, rawEntryOptions) {
+  ResultQueue queue;
+  std::shared_ptr<const RawRecognitionResult> raw =
+      std::make_shared<const RawRecognitionResult>(
+          std::make_shared<const std::string>(
+              "{\"alternatives\": [{\"text\": \"um\", \"score\": 90, "
+              "\"words\": [{\"text\": \"um\", \"score\": 90}]}]}"),
+          RecognitionResult::Code::RECOGNIZED, true, 0, true);
+  ASRResultDecoder::Options options;
+  options.words = false;
+  EXPECT_TRUE(queue.push({nullptr, raw, options}));
+  EXPECT_TRUE(queue.push({nullptr, raw}));
+
+  RecognitionResult res;
+  ASSERT_TRUE(queue.pop(res));
+  ASSERT_EQ(1, res.getAlternatives().size());
+  EXPECT_TRUE(res.getAlternatives()[0].getWords().empty());
+  ASSERT_TRUE(queue.pop(res));
+  EXPECT_EQ(1, res.getAlternatives()[0].getWords().size());
+}
+
+TEST(ResultQueueTest, invalidRawEntry) {
+  ResultQueue queue;
+  EXPECT_TRUE(queue.push(
+      {nullptr, std::make_shared<const RawRecognitionResult>(
+                    std::make_shared<const std::string>("{\"alternatives\": ["),
+                    RecognitionResult::Code::RECOGNIZED, true, 0, false)}));
+  EXPECT_TRUE(queue.push(entry(RecognitionResult::Code::NO_MATCH)));
+
+  // the invalid result is dropped, not thrown
+  RecognitionResult res;
+  ASSERT_TRUE(queue.pop(res));
+  EXPECT_EQ(RecognitionResult::Code::NO_MATCH, res.getCode());
+  EXPECT_EQ(1, queue.takeInvalid());
+  EXPECT_EQ(0, queue.takeInvalid());
+  EXPECT_FALSE(queue.pop(res));
+
+  RecognizerMetrics metrics;
+  queue.metrics(metrics);
+  EXPECT_EQ(1, metrics.results_dropped_);
+}
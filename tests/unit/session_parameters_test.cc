@@ -0,0 +1,159 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include <cpqd/asr-client/recognition_config.h>
+
+#include "src/session_parameters.h"
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+TEST(SessionParametersTest, serialize) {
+  std::unique_ptr<RecognitionConfig> config = RecognitionConfig::Builder()
+      .maxSentences(3)
+      .recognitionTimeoutEnabled(true)
+      .recognitionTimeoutSeconds(30)
+      .startInputTimers(true)
+      .continuousMode(true)
+      .build();
+
+  std::shared_ptr<const SessionParameters::Headers> headers =
+      SessionParameters::serialize(*config);
+  SessionParameters::Headers expected = {
+      {"decoder.continuousMode", "true"},
+      {"decoder.maxSentences", "3"},
+      {"decoder.startInputTimers", "1"},
+      {"recognitionTimeout.enabled", "1"},
+      {"recognitionTimeout.value", "30"},
+  };
+  EXPECT_EQ(expected, *headers);
+}
+
+TEST(SessionParametersTest, deferInputTimers) {
+  std::unique_ptr<RecognitionConfig> config = RecognitionConfig::Builder()
+      .startInputTimers(true)
+      .build();
+
+  std::shared_ptr<const SessionParameters::Headers> headers =
+      SessionParameters::serialize(*config, true);
+  EXPECT_EQ("0", headers->at("decoder.startInputTimers"));
+
+  SessionParameters::Headers expected = {
+      {"decoder.startInputTimers", "0"},
+  };
+  EXPECT_EQ(expected, *SessionParameters::defaults(true));
+  EXPECT_TRUE(SessionParameters::defaults(false)->empty());
+}
+
+TEST(SessionParametersTest, onlyChangesAreSent) {
+  SessionParameters session;
+  SessionParameters::Headers first = {
+      {"decoder.maxSentences", "3"},
+      {"decoder.continuousMode", "true"},
+  };
+
+  ASSERT_TRUE(session.prepare(first));
+  EXPECT_EQ(first, session.pending());
+  session.acknowledge();
+  EXPECT_EQ(first, session.current());
+
+  // same parameters, nothing to send
+  ASSERT_TRUE(session.prepare(first));
+  EXPECT_TRUE(session.pending().empty());
+
+  // a changed value and a boolean back to its default
+  SessionParameters::Headers second = {{"decoder.maxSentences", "5"}};
+  ASSERT_TRUE(session.prepare(second));
+  SessionParameters::Headers delta = {
+      {"decoder.continuousMode", "false"},
+      {"decoder.maxSentences", "5"},
+  };
+  EXPECT_EQ(delta, session.pending());
+  session.acknowledge();
+  EXPECT_EQ(second, session.current());
+}
+
+TEST(SessionParametersTest, resetNeedsNewSession) {
+  SessionParameters session;
+  SessionParameters::Headers headers = {{"endpointer.waitEnd", "900"}};
+  ASSERT_TRUE(session.prepare(headers));
+  session.acknowledge();
+
+  // the server default of a numeric parameter is unknown
+  EXPECT_FALSE(session.prepare(SessionParameters::Headers()));
+  EXPECT_TRUE(session.pending().empty());
+
+  session.reset();
+  EXPECT_TRUE(session.prepare(SessionParameters::Headers()));
+  EXPECT_TRUE(session.pending().empty());
+}
+
+TEST(SessionParametersTest, startInputTimersBackToDefault) {
+  SessionParameters session;
+  SessionParameters::Headers start = {{"decoder.startInputTimers", "1"}};
+  ASSERT_TRUE(session.prepare(start));
+  session.acknowledge();
+  // the server default, nothing to remember
+  EXPECT_TRUE(session.current().empty());
+
+  // the same config again, the session is already there
+  ASSERT_TRUE(session.prepare(start));
+  EXPECT_TRUE(session.pending().empty());
+
+  // omitted by the next recognition, the timers still start
+  ASSERT_TRUE(session.prepare(SessionParameters::Headers()));
+  EXPECT_TRUE(session.pending().empty());
+}
+
+TEST(SessionParametersTest, explicitDefaultSentOnce) {
+  SessionParameters session;
+  SessionParameters::Headers headers = {{"Infer-age-enabled", "false"}};
+  // a new session gets the config as is
+  ASSERT_TRUE(session.prepare(headers));
+  EXPECT_EQ(headers, session.pending());
+  session.acknowledge();
+
+  ASSERT_TRUE(session.prepare(headers));
+  EXPECT_TRUE(session.pending().empty());
+}
+
+TEST(SessionParametersTest, deferredTimersKept) {
+  SessionParameters session;
+  std::shared_ptr<const SessionParameters::Headers> headers =
+      SessionParameters::defaults(true);
+  const SessionParameters::Headers& deferred = *headers;
+  ASSERT_TRUE(session.prepare(deferred));
+  EXPECT_EQ(deferred, session.pending());
+  session.acknowledge();
+  EXPECT_EQ(deferred, session.current());
+
+  // every deferred recognition reuses the session as is
+  ASSERT_TRUE(session.prepare(deferred));
+  EXPECT_TRUE(session.pending().empty());
+
+  // a recognition without deferral starts them again
+  ASSERT_TRUE(session.prepare(SessionParameters::Headers()));
+  SessionParameters::Headers restart = {{"decoder.startInputTimers", "1"}};
+  EXPECT_EQ(restart, session.pending());
+  session.acknowledge();
+  EXPECT_TRUE(session.current().empty());
+}
@@ -18,12 +18,14 @@
 
 #include "test_config.h"
 
+#include <atomic>
 #include <chrono>
 #include <string>
 #include <thread>
 
 #include <cpqd/asr-client/file_audio_source.h>
 #include <cpqd/asr-client/buffer_audio_source.h>
+#include <cpqd/asr-client/completion_queue.h>
 #include <cpqd/asr-client/recognition_config.h>
 #include <cpqd/asr-client/recognition_exception.h>
 #include <cpqd/asr-client/speech_recog.h>
@@ -51,6 +53,12 @@
  * ok-ish:   connectOnRecognize (doesn't test connection per se, only the object status)
  * ok-ish:   multipleAutoClose  (doesn't test connection per se, only the object status)
  * ok:       sessionTimeout
+ *           preparedRecognition
+ *           sessionReuse
+ *           releaseSession
+ *           autoCloseKeepsListeners
+ *           completionQueueError
+ *           completionQueueUnreachable
  */
 
 
@@ -67,6 +75,43 @@ std::unique_ptr<SpeechRecognizer> defaultBuild(){
 }
 
 
+/* Recognize the phone number audio, true if it was recognized */
+bool recognizePhone(SpeechRecognizer& asr) {
+  std::unique_ptr<LanguageModelList> lm =
+      LanguageModelList::Builder().addFromURI(test::grammar_phone_uri).build();
+  asr.recognize(std::make_shared<FileAudioSource>(test::audio_phone_8k),
+                std::move(lm));
+  for (RecognitionResult& res : asr.waitRecognitionResult()) {
+    if (res.getCode() == RecognitionResult::Code::RECOGNIZED) return true;
+  }
+  return false;
+}
+
+/* Counts the events of every recognition of a recognizer */
+class CountingListener : public RecognitionListener {
+ public:
+  CountingListener(std::atomic<int>& listening, std::atomic<int>& results)
+      : listening_(listening), results_(results) {}
+
+  void onListening() { ++listening_; }
+  void onSpeechStart(int) {}
+  void onSpeechStop(int) {}
+  void onPartialRecognition(const PartialRecognition&) {}
+  void onRecognitionResult(const RecognitionResult&) { ++results_; }
+  void onError(RecognitionError&) {}
+
+ private:
+  std::atomic<int>& listening_;
+  std::atomic<int>& results_;
+};
+
+/* Listener callbacks may run after waitRecognitionResult() returns */
+void waitCount(const std::atomic<int>& count, int expected) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (count < expected && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
 /*Class for simulating noInputTimeout*/
 class DelayedFileAudioSource: public FileAudioSource {
 public:
@@ -100,7 +145,7 @@ TEST(RecognizerTest, basicGrammar) {
     if(res.getCode() != RecognitionResult::Code::RECOGNIZED) continue;
     at_least_one_high_confidence = true;
 
-    for (RecognitionResult::Alternative& alt : res.getAlternatives()) {
+    for (const RecognitionResult::Alternative& alt : res.getAlternatives()) {
       std::cout << "alt.getConfidence(): " << alt.getConfidence() << std::endl;
       ASSERT_GE(alt.getConfidence(), 90);
     }
@@ -108,6 +153,28 @@ TEST(RecognizerTest, basicGrammar) {
   ASSERT_EQ(true, at_least_one_high_confidence) << "No results with high confidence!";
 }
 
+TEST(RecognizerTest, preparedRecognition) {
+  std::shared_ptr<const LanguageModelList> lm =
+      LanguageModelList::Builder().addFromURI(test::grammar_phone_uri).build();
+  std::unique_ptr<SpeechRecognizer> asr = defaultBuild();
+
+  // no audio yet, the recognition is armed in the background
+  EXPECT_THROW(asr->recognize(std::make_shared<FileAudioSource>(
+                   test::audio_phone_8k)), RecognitionException);
+  asr->prepareRecognition(lm);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!asr->isArmed() && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_TRUE(asr->isArmed());
+
+  asr->recognize(std::make_shared<FileAudioSource>(test::audio_phone_8k));
+  std::vector<RecognitionResult> result = asr->waitRecognitionResult();
+  asr->close();
+
+  ASSERT_LT(0, result.size());
+  EXPECT_EQ(RecognitionResult::Code::RECOGNIZED, result[0].getCode());
+}
+
 TEST(NoGrammarTest, basicGrammarClearVoice) {
   std::shared_ptr<AudioSource> audio =
       std::make_shared<FileAudioSource>(test::previsao_tempo_8k);
@@ -125,7 +192,7 @@ TEST(NoGrammarTest, basicGrammarClearVoice) {
     if(res.getCode() != RecognitionResult::Code::RECOGNIZED) continue;
     at_least_one_high_confidence = true;
 
-    for (RecognitionResult::Alternative& alt : res.getAlternatives()) {
+    for (const RecognitionResult::Alternative& alt : res.getAlternatives()) {
       std::cout << "alt.getConfidence(): " << alt.getConfidence() << std::endl;
       ASSERT_GE(alt.getConfidence(), 90);
     }
@@ -506,6 +573,117 @@ TEST(RecognizerTest, multipleAutoClose) {
 }
 
 
+TEST(RecognizerTest, sessionReuse) {
+  std::unique_ptr<SpeechRecognizer> asr = defaultBuild();
+
+  // the second recognition goes straight to START_RECOGNITION
+  ASSERT_TRUE(recognizePhone(*asr));
+  ASSERT_TRUE(recognizePhone(*asr));
+  RecognizerMetrics metrics = asr->getMetrics();
+  EXPECT_EQ(1u, metrics.sessions_created_);
+  EXPECT_EQ(1u, metrics.connections_);
+  asr->close();
+}
+
+TEST(RecognizerTest, releaseSession) {
+  std::unique_ptr<SpeechRecognizer> asr = defaultBuild();
+
+  ASSERT_TRUE(recognizePhone(*asr));
+  asr->releaseSession();
+  ASSERT_EQ(true, asr->isOpen()) << "Releasing the session keeps the connection";
+
+  // a new session on the same connection
+  ASSERT_TRUE(recognizePhone(*asr));
+  RecognizerMetrics metrics = asr->getMetrics();
+  EXPECT_EQ(2u, metrics.sessions_created_);
+  EXPECT_EQ(1u, metrics.connections_);
+  asr->close();
+}
+
+TEST(RecognizerTest, autoCloseKeepsListeners) {
+  std::atomic<int> listening{0};
+  std::atomic<int> results{0};
+  std::unique_ptr<SpeechRecognizer> asr = SpeechRecognizer::Builder()
+      .serverUrl(test::server_url)
+      .recogConfig(RecognitionConfig::Builder().build())
+      .credentials(test::username, test::password)
+      .maxWaitSeconds(30)
+      .autoClose(true)
+      .addListener(std::unique_ptr<RecognitionListener>(
+          new CountingListener(listening, results)))
+      .build();
+
+  for (int i = 1; i <= 2; ++i) {
+    ASSERT_TRUE(recognizePhone(*asr));
+    ASSERT_EQ(false, asr->isOpen()) << "Connection should close after every recognition!";
+
+    // the connection opened again reaches the same listener
+    waitCount(listening, i);
+    waitCount(results, i);
+    EXPECT_EQ(i, listening.load());
+    EXPECT_LE(i, results.load());
+  }
+  EXPECT_EQ(2u, asr->getMetrics().connections_);
+  EXPECT_EQ(2u, asr->getMetrics().sessions_created_);
+}
+
+TEST(RecognizerTest, completionQueueError) {
+  std::shared_ptr<CompletionQueue> queue = std::make_shared<CompletionQueue>();
+  std::unique_ptr<SpeechRecognizer> asr = SpeechRecognizer::Builder()
+      .serverUrl(test::server_url)
+      .recogConfig(RecognitionConfig::Builder().build())
+      .credentials(test::username, test::password)
+      .maxWaitSeconds(30)
+      .completionQueue(queue, 7)
+      .build();
+
+  // the server refuses the grammar
+  std::string str_gram =  "#ABNF 1.0 UTF-8;\n"
+                          "language pt-BR;\n"
+                          "tag-format <semantics/1.0>;\n"
+                          "mode voice;\n"
+                          "root $rodfot;\n"
+                          "$root = sim | não;\n";
+  asr->recognize(std::make_shared<FileAudioSource>(test::audio_yes_16k),
+                 LanguageModelList::Builder().addInlineGrammar(str_gram).build());
+  CompletionQueue::Event event;
+  ASSERT_TRUE(queue->waitAny(event, std::chrono::seconds(30)));
+  EXPECT_EQ(7u, event.id_);
+  EXPECT_FALSE(event.ok());
+
+  // the failed recognition is over without waitRecognitionResult()
+  ASSERT_NO_THROW(asr->recognize(
+      std::make_shared<FileAudioSource>(test::audio_phone_8k),
+      LanguageModelList::Builder().addFromURI(test::grammar_phone_uri).build()));
+  ASSERT_TRUE(queue->waitAny(event, std::chrono::seconds(30)));
+  EXPECT_TRUE(event.ok());
+  EXPECT_LT(0u, event.results_.size());
+  asr->close();
+}
+
+TEST(RecognizerTest, completionQueueUnreachable) {
+  std::shared_ptr<CompletionQueue> queue = std::make_shared<CompletionQueue>();
+  std::unique_ptr<SpeechRecognizer> asr = SpeechRecognizer::Builder()
+      .serverUrl("ws://127.0.0.1:1/asr/v2")
+      .recogConfig(RecognitionConfig::Builder().build())
+      .maxWaitSeconds(30)
+      .completionQueue(queue, 7)
+      .build();
+
+  // the failure is thrown once and never posted, every attempt connects
+  for (int i = 0; i < 2; ++i) {
+    try {
+      asr->recognize(
+          std::make_shared<FileAudioSource>(test::audio_phone_8k),
+          LanguageModelList::Builder().addFromURI(test::grammar_phone_uri).build());
+      FAIL() << "Expected a connection failure";
+    } catch (RecognitionException& e) {
+      EXPECT_EQ(RecognitionError::Code::CONNECTION_FAILURE, e.getCode());
+    }
+    EXPECT_EQ(0u, queue->size());
+  }
+}
+
 TEST(RecognizerTest, sessionTimeout) {
   std::shared_ptr<AudioSource> audio =
       std::make_shared<FileAudioSource>(test::audio_phone_8k);
@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <openssl/bio.h>
+#include <openssl/ssl.h>
+
+#include <chrono>
+#include <string>
+
+#include "src/tls_session_cache.h"
+#include "test_config.h"
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+class TlsSessionCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    SSL_library_init();
+    server_ = SSL_CTX_new(SSLv23_server_method());
+    ASSERT_EQ(1, SSL_CTX_use_certificate_file(server_, test::tls_cert.c_str(),
+                                              SSL_FILETYPE_PEM));
+    ASSERT_EQ(1, SSL_CTX_use_PrivateKey_file(server_, test::tls_key.c_str(),
+                                             SSL_FILETYPE_PEM));
+    client_ = SSL_CTX_new(SSLv23_client_method());
+    cache_.attach(client_);
+  }
+
+  void TearDown() override {
+    SSL_CTX_free(client_);
+    SSL_CTX_free(server_);
+  }
+
+  // Handshake over an in-memory BIO pair, returns whether it was resumed
+  bool handshake(const std::string& host) {
+    SSL* client = SSL_new(client_);
+    SSL* server = SSL_new(server_);
+    BIO* client_bio;
+    BIO* server_bio;
+    BIO_new_bio_pair(&client_bio, 0, &server_bio, 0);
+    SSL_set_bio(client, client_bio, client_bio);
+    SSL_set_bio(server, server_bio, server_bio);
+    SSL_set_connect_state(client);
+    SSL_set_accept_state(server);
+
+    bool observed = false;
+    bool resumed = false;
+    cache_.prepare(client, host,
+                   [&](bool reused, std::chrono::microseconds) {
+                     ++handshakes_;
+                     observed = true;
+                     resumed = reused;
+                   });
+
+    bool client_done = false;
+    bool server_done = false;
+    for (int i = 0; i < 100 && !(client_done && server_done); ++i) {
+      if (!client_done) client_done = SSL_do_handshake(client) == 1;
+      if (!server_done) server_done = SSL_do_handshake(server) == 1;
+    }
+    EXPECT_TRUE(client_done && server_done);
+
+    // TLSv1.3 tickets arrive after the handshake
+    char byte;
+    SSL_read(client, &byte, 1);
+
+    // sessions of connections not shut down are not resumable
+    SSL_shutdown(client);
+    SSL_free(client);
+    SSL_free(server);
+    EXPECT_TRUE(observed);
+    return resumed;
+  }
+
+  SSL_CTX* server_ = nullptr;
+  SSL_CTX* client_ = nullptr;
+  TlsSessionCache cache_;
+  int handshakes_ = 0;
+};
+
+TEST_F(TlsSessionCacheTest, resumeByHost) {
+  EXPECT_FALSE(handshake("asr.example:443"));
+  EXPECT_EQ(1, cache_.size());
+
+  EXPECT_TRUE(handshake("asr.example:443"));
+  EXPECT_FALSE(handshake("other.example:443"));
+  EXPECT_EQ(2, cache_.size());
+  EXPECT_EQ(3, handshakes_);
+}
+
+TEST_F(TlsSessionCacheTest, clear) {
+  handshake("asr.example:443");
+  cache_.clear();
+  EXPECT_EQ(0, cache_.size());
+  EXPECT_FALSE(handshake("asr.example:443"));
+}
@@ -0,0 +1,81 @@
+/*****************************************************************************
+ * Copyright 2017 CPqD. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+
+#include <cpqd/asr-client/uplink_shaper.h>
+
+/*
+ * Offline tests, no ASR server is needed
+ */
+
+TEST(UplinkShaperTest, unlimited) {
+  UplinkShaper shaper;
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(0, shaper.reserve(UplinkClass::BULK, 1 << 20).count());
+
+  UplinkShaper::Stats stats = shaper.stats(UplinkClass::BULK);
+  EXPECT_EQ(100u << 20, stats.bytes_);
+  EXPECT_EQ(0u, stats.throttles_);
+  EXPECT_GT(stats.bytes_per_second_, 0);
+  EXPECT_EQ(0u, shaper.stats(UplinkClass::LIVE).bytes_);
+}
+
+TEST(UplinkShaperTest, invalidBurst) {
+  UplinkShaper::Options options;
+  options.live_rate_ = 1000;
+  options.live_burst_ = 0;
+  EXPECT_THROW(UplinkShaper shaper(options), std::invalid_argument);
+}
+
+TEST(UplinkShaperTest, tokenBucket) {
+  UplinkShaper::Options options;
+  options.bulk_rate_ = 1000;
+  options.bulk_burst_ = 1000;
+  UplinkShaper shaper(options);
+
+  // the burst goes at once, then the debt is paid at the rate
+  EXPECT_EQ(0, shaper.reserve(UplinkClass::BULK, 1000).count());
+  std::chrono::microseconds hold = shaper.reserve(UplinkClass::BULK, 500);
+  EXPECT_GT(hold.count(), 400000);
+  EXPECT_LE(hold.count(), 500000);
+  // the next message waits behind this one
+  EXPECT_GT(shaper.reserve(UplinkClass::BULK, 500).count(), 900000);
+
+  UplinkShaper::Stats stats = shaper.stats(UplinkClass::BULK);
+  EXPECT_EQ(2u, stats.throttles_);
+  EXPECT_GT(stats.throttled_time_.count(), 1300000);
+}
+
+TEST(UplinkShaperTest, separateBudgets) {
+  UplinkShaper::Options options;
+  options.bulk_rate_ = 1000;
+  options.bulk_burst_ = 1000;
+  UplinkShaper shaper(options);
+
+  // saturated bulk audio does not hold live audio back
+  EXPECT_EQ(0, shaper.reserve(UplinkClass::BULK, 1000).count());
+  EXPECT_GT(shaper.reserve(UplinkClass::BULK, 1000).count(), 0);
+  EXPECT_EQ(0, shaper.reserve(UplinkClass::LIVE, 1 << 20).count());
+  EXPECT_EQ(0u, shaper.stats(UplinkClass::LIVE).throttles_);
+
+  // reconfigured buckets start full
+  shaper.configure(options);
+  EXPECT_EQ(0, shaper.reserve(UplinkClass::BULK, 1000).count());
+}
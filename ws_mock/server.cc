@@ -126,7 +126,26 @@ class utility_server {
             m_endpoint.send(hdl, msg.c_str(), opcode);
     }
 
+    void close(const websocketpp::connection_hdl& hdl) {
+        websocketpp::lib::error_code ec;
+        if (tls_enable)
+            m_endpoint_tls.close(hdl, websocketpp::close::status::going_away, "drop", ec);
+        else
+            m_endpoint.close(hdl, websocketpp::close::status::going_away, "drop", ec);
+    }
+
+    // Refuse the handshake once after a dropped connection
+    bool validate(websocketpp::connection_hdl) {
+        if (!refuse_next_) return true;
+        std::cout << "======================================= REFUSED ===\n";
+        refuse_next_ = false;
+        return false;
+    }
+
     void init() {
+        // A lost connection, for the replay tests
+        drop_once_ = std::getenv("DROP_ONCE") != nullptr;
+
         if (tls_enable) {
             // Set logging settings
             m_endpoint_tls.set_error_channels(websocketpp::log::elevel::all);
@@ -147,6 +166,13 @@ class utility_server {
                 bind(&utility_server::on_open, this, std::placeholders::_1));
             m_endpoint_tls.set_close_handler(
                 bind(&utility_server::on_close, this, std::placeholders::_1));
+            m_endpoint_tls.set_validate_handler(
+                bind(&utility_server::validate, this, std::placeholders::_1));
+
+            // A dead peer, for the keepalive tests
+            if (std::getenv("NO_PONG"))
+                m_endpoint_tls.set_ping_handler(
+                    [](websocketpp::connection_hdl, std::string) { return false; });
         } else {
             // Set logging settings
             m_endpoint.set_error_channels(websocketpp::log::elevel::all);
@@ -164,6 +190,13 @@ class utility_server {
                 bind(&utility_server::on_open, this, std::placeholders::_1));
             m_endpoint.set_close_handler(
                 bind(&utility_server::on_close, this, std::placeholders::_1));
+            m_endpoint.set_validate_handler(
+                bind(&utility_server::validate, this, std::placeholders::_1));
+
+            // A dead peer, for the keepalive tests
+            if (std::getenv("NO_PONG"))
+                m_endpoint.set_ping_handler(
+                    [](websocketpp::connection_hdl, std::string) { return false; });
         }
     }
     utility_server(int p, bool enable) : port(p), tls_enable(enable) {
@@ -363,6 +396,13 @@ class utility_server {
             if (it != session_map.end()) {
                 if (it->second.audio_counter < END_RECOGNIZE) it->second.audio_counter++;
             }
+            if (drop_once_ && it->second.audio_counter == 3) {
+                std::cout << "======================================= DROP ===\n";
+                drop_once_ = false;
+                refuse_next_ = true;
+                close(hdl);
+                return;
+            }
             try {
                 auto last = parser.Get("LastPacket");
                 if (last.valid()) {
@@ -456,6 +496,8 @@ class utility_server {
     int port = 9002;
     bool tls_enable = false;
     int m_next_sessionid = 0;
+    bool drop_once_ = false;
+    bool refuse_next_ = false;
     con_list session_map;
     WsParser parser_;
 };